@@ -9,6 +9,15 @@ CalibrationLib calib;
 const char* TEMP_OFFSET_KEY = "temp_offset";
 const char* PRESSURE_OFFSET_KEY = "pres_offset";
 const char* HUMIDITY_OFFSET_KEY = "hum_offset";
+const char* PRESSURE_THERMAL_KEY = "pres_thermal";
+
+// Pressure drift measured in a climate chamber against a reference
+// barometer: offset (hPa) and gain at each temperature (°C)
+const float CHAMBER_TEMPS[] = {0.0f, 20.0f, 40.0f, 60.0f};
+const float CHAMBER_OFFSETS[] = {0.45f, 0.0f, -0.38f, -0.90f};
+const float CHAMBER_SCALES[] = {1.0004f, 1.0f, 0.9997f, 0.9992f};
+
+ThermalCalibration pressureThermal;
 
 void setup() {
   Serial.begin(115200);
@@ -33,6 +42,13 @@ void setup() {
   Serial.printf("Temperature offset: %.2f°C\n", tempOffset);
   Serial.printf("Pressure offset: %.2f hPa\n", pressOffset);
   Serial.printf("Humidity offset: %.2f%%\n", humOffset);
+  
+  // Temperature-compensated pressure; store the chamber table on first run
+  if (calib.loadThermalCalibration(PRESSURE_THERMAL_KEY, pressureThermal) != CAL_OK) {
+    pressureThermal.setTable(CHAMBER_TEMPS, CHAMBER_OFFSETS, CHAMBER_SCALES, 4);
+    calib.storeThermalCalibration(PRESSURE_THERMAL_KEY, pressureThermal);
+  }
+  Serial.printf("Pressure compensation: %u points\n", pressureThermal.size());
 }
 
 void loop() {
@@ -48,7 +64,8 @@ void loop() {
   calib.getCalibrationValue(HUMIDITY_OFFSET_KEY, humOffset, 0.0f);
   
   float calibratedTemp = rawTemp + tempOffset;
-  float calibratedPressure = rawPressure + pressOffset;
+  // Compensate drift at the sensor's own temperature, then apply the offset
+  float calibratedPressure = pressureThermal.apply(rawPressure, rawTemp) + pressOffset;
   float calibratedHumidity = rawHumidity + humOffset;
   
   // Print results
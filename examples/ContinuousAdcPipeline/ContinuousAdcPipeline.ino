@@ -0,0 +1,161 @@
+/*
+  ContinuousAdcPipeline.ino
+  Example for CalibrationLib: High-Rate Calibrated ADC Acquisition
+
+  This example replaces an analogRead() loop with the ESP32's continuous
+  (DMA) ADC mode and calibrates the samples in blocks as they arrive. It
+  shows how to:
+  - Stream two ADC1 channels at 20 kHz each
+  - Apply stored per-channel calibration transforms in batches
+  - Hand calibrated blocks from a producer task to loop() through a
+    lock-free ring buffer
+
+  Features:
+  - DMA-driven sampling, no per-sample analogRead() calls
+  - One applyBatch() call per 64-sample block
+  - Producer task on core 0, consumer in loop()
+  - Dropped block and throughput reporting
+  - Synthetic signal fallback on boards without the continuous ADC driver,
+    paced to the same sample rate
+
+  Hardware Setup:
+  - ESP32 development board
+  - Two analog inputs (e.g. potentiometers):
+    * Channel 0 -> GPIO34 (ADC1_CH6)
+    * Channel 1 -> GPIO35 (ADC1_CH7)
+  - Serial connection (115200 baud)
+
+  Calibration:
+  - Namespace: "pot_cal"
+  - Keys: "pot_model" (channel 0, as written by PotentiometerCalibration)
+    and "pot2_model" (channel 1); missing keys leave the raw counts
+
+  Output Format:
+  - Once per second, per channel: blocks, mean and min/max of the
+    calibrated values, then the total sample rate and dropped blocks
+
+  Dependencies:
+  - ESP32 Arduino Core 3.x (ESP-IDF 5 continuous ADC driver)
+  - CalibrationLib
+
+  Author: Judas Sithole (judassithole@duck.com)
+  Created: 2025
+  License: MIT
+*/
+
+#include <CalibrationLib.h>
+
+CalibrationLib calibration;
+
+const uint32_t RATE_PER_CHANNEL = 20000;   // Hz
+
+#if CALIBRATION_HAS_CONTINUOUS_ADC
+const uint8_t PINS[] = {34, 35};
+ContinuousAdcSource source;
+#else
+SyntheticSource source(2, RATE_PER_CHANNEL);
+#endif
+
+CalibrationTransform channelModels[2];
+CalibrationPipeline pipeline(source);
+
+// Per-channel statistics for the current report interval
+uint32_t blocks[2];
+double sums[2];
+uint32_t counts[2];
+float lows[2];
+float highs[2];
+unsigned long lastReport = 0;
+
+// Producer: keeps the DMA buffer drained and the ring filled
+void acquisitionTask(void* parameter) {
+#if CALIBRATION_HAS_CONTINUOUS_ADC
+  for (;;) {
+    if (pipeline.process() == 0) {
+      vTaskDelay(1);
+    }
+  }
+#else
+  // The synthetic source never runs dry, so hold it to the sample rate by
+  // the clock. A priority 5 task that never blocks starves IDLE0 on this
+  // core and trips the task watchdog.
+  const uint32_t sampleRate = 2 * RATE_PER_CHANNEL;
+  uint32_t due = micros();
+  uint32_t remainder = 0;
+  for (;;) {
+    uint64_t scaled = (uint64_t)pipeline.process() * 1000000UL + remainder;
+    due += scaled / sampleRate;
+    remainder = scaled % sampleRate;
+    int32_t ahead = (int32_t)(due - micros());
+    vTaskDelay(ahead >= 1000 ? pdMS_TO_TICKS(ahead / 1000) : 1);
+  }
+#endif
+}
+
+void resetStats() {
+  for (int c = 0; c < 2; c++) {
+    blocks[c] = 0;
+    sums[c] = 0;
+    counts[c] = 0;
+    lows[c] = INFINITY;
+    highs[c] = -INFINITY;
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+  
+  Serial.println("Continuous ADC Pipeline Example");
+  Serial.println("===============================");
+  
+  calibration.begin("pot_cal");
+  calibration.loadTransform("pot_model", channelModels[0]);
+  calibration.loadTransform("pot2_model", channelModels[1]);
+  pipeline.attachChannel(0, channelModels[0]);
+  pipeline.attachChannel(1, channelModels[1]);
+  
+#if CALIBRATION_HAS_CONTINUOUS_ADC
+  if (!source.begin(PINS, 2, 2 * RATE_PER_CHANNEL)) {
+    Serial.println("Failed to start continuous ADC!");
+    return;
+  }
+#else
+  Serial.println("No continuous ADC driver, using a synthetic signal");
+  source.setSignal(0, 2048, 1000, 5);
+  source.setSignal(1, 1000);
+#endif
+  
+  resetStats();
+  xTaskCreatePinnedToCore(acquisitionTask, "adc_pipeline", 4096, nullptr, 5, nullptr, 0);
+}
+
+void loop() {
+  // Whole blocks only: no per-sample calls between the DMA and here
+  while (const CalibratedBlock* block = pipeline.peek()) {
+    const uint8_t c = block->channel;
+    for (uint16_t i = 0; i < block->count; i++) {
+      float v = block->values[i];
+      sums[c] += v;
+      if (v < lows[c]) lows[c] = v;
+      if (v > highs[c]) highs[c] = v;
+    }
+    counts[c] += block->count;
+    blocks[c]++;
+    pipeline.release();
+  }
+  
+  if (millis() - lastReport >= 1000) {
+    unsigned long elapsed = millis() - lastReport;
+    lastReport = millis();
+    for (int c = 0; c < 2; c++) {
+      if (counts[c]) {
+        Serial.printf("ch%d: %lu blocks, mean %.2f, range %.2f..%.2f\n", c, (unsigned long)blocks[c],
+                      sums[c] / counts[c], lows[c], highs[c]);
+      }
+    }
+    Serial.printf("%.0f samples/s, %lu dropped blocks\n\n",
+                  (counts[0] + counts[1]) * 1000.0 / elapsed, (unsigned long)pipeline.droppedBlocks());
+    resetStats();
+  }
+}
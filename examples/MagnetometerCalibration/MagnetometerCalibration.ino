@@ -0,0 +1,151 @@
+/*
+  MagnetometerCalibration.ino
+  Example for CalibrationLib: On-Device Hard/Soft-Iron Calibration
+
+  This example demonstrates how to calibrate a magnetometer on the device
+  itself instead of with an offline tool. While the board is rotated, each
+  reading is folded into a streaming ellipsoid fit; no samples are stored.
+  It shows how to:
+  - Collect readings from loop() without blocking
+  - Track how much of the rotation sphere has been covered
+  - Fit hard-iron offset and soft-iron matrix on the device
+  - Persist the model and apply it to every reading
+
+  Features:
+  - Streaming 9-parameter ellipsoid fit (constant memory)
+  - Orientation coverage feedback
+  - Compact binary model storage
+  - Calibrated field strength and heading output
+
+  Calibration Process:
+  1. Enter 'm' to start capturing
+  2. Slowly rotate the board through every orientation
+     (figure-eight motions work well) until coverage reaches 100%
+  3. Enter 'f' to fit and store the model
+
+  Hardware Setup:
+  - ESP32 development board
+  - HMC5883L magnetometer (I2C)
+  - Connections:
+    * SDA: GPIO21 (default)
+    * SCL: GPIO22 (default)
+
+  Serial Interface:
+  - Baud Rate: 115200
+  - Command 'm': Start capturing readings
+  - Command 'f': Finish, fit and store calibration
+  - Command 'x': Discard calibration (use raw readings)
+
+  Dependencies:
+  - ESP32 Arduino Core
+  - Wire Library
+  - Adafruit HMC5883 Unified Library
+  - CalibrationLib
+
+  Note: Keep the board away from motors, speakers and steel
+  tools while calibrating; they distort the field being measured.
+
+  Author: Judas Sithole (judassithole@duck.com)
+  Created: 2025
+  License: MIT
+*/
+
+#include <CalibrationLib.h>
+#include <Wire.h>
+#include <Adafruit_HMC5883_U.h>
+
+CalibrationLib calibration;
+Adafruit_HMC5883_Unified mag = Adafruit_HMC5883_Unified(12345);
+
+AxisCalibration magModel;
+EllipsoidFitter fitter;
+bool capturing = false;
+unsigned long lastSample = 0;
+unsigned long lastPrint = 0;
+
+void setup() {
+    Serial.begin(115200);
+    Wire.begin();
+    
+    if (!mag.begin()) {
+        Serial.println("Could not find HMC5883L sensor!");
+        return;
+    }
+    
+    calibration.begin("magnetometer");
+    if (calibration.loadAxisCalibration("mag_model", magModel) == CAL_OK) {
+        const float* bias = magModel.bias();
+        Serial.printf("Loaded hard iron: %.2f %.2f %.2f uT\n", bias[0], bias[1], bias[2]);
+    } else {
+        Serial.println("No calibration stored, enter 'm' to start");
+    }
+    
+    // Ignore readings within 1 uT of the last one so resting does not skew the fit
+    fitter.setMinSpacing(1.0f);
+}
+
+void finishCapture() {
+    capturing = false;
+    
+    float rms;
+    if (!fitter.fit(magModel, 0.0f, &rms)) {
+        Serial.println("Fit failed: rotate through more orientations and try again");
+        magModel.setIdentity();
+        return;
+    }
+    calibration.storeAxisCalibration("mag_model", magModel);
+    
+    const float* bias = magModel.bias();
+    Serial.printf("Stored calibration from %lu readings (residual %.4f)\n",
+                  (unsigned long)fitter.count(), rms);
+    Serial.printf("Hard iron: %.2f %.2f %.2f uT\n", bias[0], bias[1], bias[2]);
+}
+
+void loop() {
+    if (Serial.available()) {
+        char cmd = Serial.read();
+        if (cmd == 'm') {
+            fitter.reset();
+            capturing = true;
+            Serial.println("Capturing, rotate the board in all directions...");
+        } else if (cmd == 'f' && capturing) {
+            finishCapture();
+        } else if (cmd == 'x') {
+            magModel.setIdentity();
+            calibration.removeCalibrationValue("mag_model");
+            Serial.println("Calibration discarded");
+        }
+    }
+    
+    // Sample at 50Hz
+    if (millis() - lastSample < 20) {
+        return;
+    }
+    lastSample = millis();
+    
+    sensors_event_t event;
+    mag.getEvent(&event);
+    float field[3] = {event.magnetic.x, event.magnetic.y, event.magnetic.z};
+    
+    if (capturing) {
+        fitter.addSample(field);
+    }
+    
+    if (millis() - lastPrint < 500) {
+        return;
+    }
+    lastPrint = millis();
+    
+    if (capturing) {
+        Serial.printf("Readings: %lu, coverage: %.0f%%\n",
+                      (unsigned long)fitter.count(), fitter.coverage() * 100.0f);
+        return;
+    }
+    
+    // Hard- and soft-iron correction in one multiply-add pass
+    magModel.apply(field, field);
+    float strength = sqrtf(field[0] * field[0] + field[1] * field[1] + field[2] * field[2]);
+    float heading = atan2f(field[1], field[0]) * 180.0f / PI;
+    if (heading < 0) heading += 360.0f;
+    Serial.printf("Field: %.2f uT, Heading: %.1f°\n", strength, heading);
+}
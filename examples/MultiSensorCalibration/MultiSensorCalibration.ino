@@ -3,14 +3,15 @@
   Example for CalibrationLib: Multiple Sensor Calibration Management
 
   This example demonstrates how to efficiently manage calibration data for multiple
-  sensors using CalibrationLib's namespace feature. It shows how to:
-  - Organize calibration data for different sensors
-  - Load and store calibration parameters per sensor
-  - Apply calibration to sensor readings in real-time
+  sensors using a single CalibrationTable. It shows how to:
+  - Keep every sensor's offset and scale in one table
+  - Load and store the whole table as one binary entry
+  - Apply calibration to a frame of readings from all sensors at once
 
   Features:
-  - Independent calibration storage for each sensor
-  - Namespace-based organization
+  - One storage entry for all sensors
+  - Struct-of-arrays coefficients, applied channel-parallel
+  - Units kept in code, out of the hot data
   - Default calibration fallback
   - Real-time calibration application
   - Persistent storage across power cycles
@@ -18,7 +19,7 @@
   Calibration Parameters per Sensor:
   - offset: Zero-point correction value
   - scale: Multiplication factor for scaling
-  - unit: Measurement unit string
+  - flags: Enabled / calibrated state
 
   Supported Sensors:
   - Temperature (Pin 36)
@@ -43,7 +44,9 @@
 
   Note: This example uses simulated sensor readings.
   For real applications, replace analogRead() with
-  actual sensor reading implementations.
+  actual sensor reading implementations. The same table
+  scales to 64 channels (CALIBRATION_TABLE_CHANNELS), e.g.
+  frames from external multiplexed ADCs.
 
   Author: Judas Sithole (judassithole@duck.com)
   Created: 2025
@@ -55,21 +58,16 @@
 // Create a single instance of the calibration library
 CalibrationLib calibration;
 
-// Simulated sensor pins
-const int temperatureSensorPin = 36;
-const int pressureSensorPin = 39;
-const int humiditySensorPin = 34;
+// One channel per sensor, in frame order
+const int SENSOR_COUNT = 3;
+const char* const sensorNames[SENSOR_COUNT] = {"Temperature", "Pressure", "Humidity"};
+const int sensorPins[SENSOR_COUNT] = {36, 39, 34};
+const char* const sensorUnits[SENSOR_COUNT] = {"C", "hPa", "%"};
+const float defaultOffsets[SENSOR_COUNT] = {5.0f, 10.0f, 2.0f};
+const float defaultScales[SENSOR_COUNT] = {0.1f, 0.01f, 0.05f};
 
-// Calibration parameters for each sensor
-struct SensorCalibration {
-  int offset;
-  float scale;
-  String unit;
-};
-
-SensorCalibration tempSensor;
-SensorCalibration pressureSensor;
-SensorCalibration humiditySensor;
+// Offsets, scales and flags for all sensors
+CalibrationTable sensorTable(SENSOR_COUNT);
 
 void setup() {
   Serial.begin(115200);
@@ -78,93 +76,77 @@ void setup() {
   Serial.println("\nMulti-Sensor Calibration Example");
   Serial.println("================================\n");
   
-  // Load calibration for temperature sensor
-  loadSensorCalibration("temp", tempSensor, 5, 0.1, "C");
-  
-  // Load calibration for pressure sensor
-  loadSensorCalibration("press", pressureSensor, 10, 0.01, "hPa");
+  calibration.begin("sensors");
+  loadSensorCalibration();
   
-  // Load calibration for humidity sensor
-  loadSensorCalibration("humid", humiditySensor, 2, 0.05, "%");
+  // Units are metadata: kept in code and never touched by apply
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    sensorTable.setUnit(i, sensorUnits[i]);
+  }
   
   // Print all calibration values
   Serial.println("\nAll Sensors Calibration Data:");
-  printSensorCalibration("Temperature", tempSensor);
-  printSensorCalibration("Pressure", pressureSensor);
-  printSensorCalibration("Humidity", humiditySensor);
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    printSensorCalibration(i);
+  }
   
   Serial.println("\nReading sensor values...");
 }
 
 void loop() {
-  // Read and display values from all sensors
-  readAndDisplaySensor("Temperature", temperatureSensorPin, tempSensor);
-  readAndDisplaySensor("Pressure", pressureSensorPin, pressureSensor);
-  readAndDisplaySensor("Humidity", humiditySensorPin, humiditySensor);
+  // Read all sensors into one frame, then calibrate the frame in one call
+  int16_t rawFrame[SENSOR_COUNT];
+  float values[SENSOR_COUNT];
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    rawFrame[i] = analogRead(sensorPins[i]);
+  }
+  sensorTable.applyFrame(rawFrame, values);
+  
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    displaySensor(i, rawFrame[i], values[i]);
+  }
   
   Serial.println("----------------------------");
   delay(2000);
 }
 
-void loadSensorCalibration(const char* sensorName, SensorCalibration &sensorCal, 
-                          int defaultOffset, float defaultScale, const char* defaultUnit) {
-  // Initialize the calibration library with the sensor's namespace
-  calibration.begin(sensorName);
-  
+void loadSensorCalibration() {
   // Check if calibration exists
-  if (calibration.hasCalibrationValue("offset") && 
-      calibration.hasCalibrationValue("scale") &&
-      calibration.hasCalibrationValue("unit")) {
-    
-    // Load existing calibration
-    calibration.getCalibrationValue("offset", sensorCal.offset);
-    calibration.getCalibrationValue("scale", sensorCal.scale);
-    calibration.getCalibrationValue("unit", sensorCal.unit);
-    
-    Serial.print("Loaded existing calibration for ");
-    Serial.println(sensorName);
-  } else {
-    // Set default calibration
-    sensorCal.offset = defaultOffset;
-    sensorCal.scale = defaultScale;
-    sensorCal.unit = defaultUnit;
-    
-    // Save the default calibration
-    calibration.setCalibrationValue("offset", sensorCal.offset);
-    calibration.setCalibrationValue("scale", sensorCal.scale);
-    calibration.setCalibrationValue("unit", sensorCal.unit.c_str());
-    
-    Serial.print("Created new calibration for ");
-    Serial.println(sensorName);
+  if (calibration.loadCalibrationTable("table", sensorTable) == CAL_OK &&
+      sensorTable.channelCount() == SENSOR_COUNT) {
+    Serial.println("Loaded existing calibration for all sensors");
+    return;
+  }
+  
+  // Set default calibration; these are not measured, so not flagged as calibrated
+  sensorTable.setChannelCount(SENSOR_COUNT);
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    sensorTable.setChannel(i, defaultOffsets[i], defaultScales[i], TABLE_CHANNEL_ENABLED);
   }
   
-  // Close this namespace before opening another
-  calibration.end();
+  // Save the default calibration
+  calibration.storeCalibrationTable("table", sensorTable);
+  Serial.println("Created new calibration for all sensors");
 }
 
-void printSensorCalibration(const char* sensorName, const SensorCalibration &sensorCal) {
-  Serial.print(sensorName);
+void printSensorCalibration(int channel) {
+  Serial.print(sensorNames[channel]);
   Serial.print(" Sensor: Offset = ");
-  Serial.print(sensorCal.offset);
+  Serial.print(sensorTable.offset(channel));
   Serial.print(", Scale = ");
-  Serial.print(sensorCal.scale, 4);
+  Serial.print(sensorTable.scale(channel), 4);
   Serial.print(", Unit = ");
-  Serial.println(sensorCal.unit);
+  Serial.print(sensorTable.unit(channel));
+  Serial.println(sensorTable.flags(channel) & TABLE_CHANNEL_CALIBRATED ? "" : " (default)");
 }
 
-void readAndDisplaySensor(const char* sensorName, int sensorPin, const SensorCalibration &sensorCal) {
-  // Read raw value
-  int rawValue = analogRead(sensorPin);
-  
-  // Apply calibration
-  float calibratedValue = (rawValue - sensorCal.offset) * sensorCal.scale;
-  
+void displaySensor(int channel, int rawValue, float calibratedValue) {
   // Display results
-  Serial.print(sensorName);
+  Serial.print(sensorNames[channel]);
   Serial.print(": Raw = ");
   Serial.print(rawValue);
   Serial.print(", Calibrated = ");
   Serial.print(calibratedValue, 2);
   Serial.print(" ");
-  Serial.println(sensorCal.unit);
-}
\ No newline at end of file
+  Serial.println(sensorTable.unit(channel));
+}
@@ -7,9 +7,9 @@
   and persistent storage of calibration values.
 
   Features:
-  - Interactive calibration process
-  - Multi-sample averaging for accuracy
-  - Real-time value scaling
+  - Interactive, non-blocking calibration process
+  - Multi-sample median, so ADC spikes do not shift the end points
+  - Real-time value scaling through a 4096-entry lookup table
   - Persistent calibration storage
   - Default value fallback
   - Serial interface for control
@@ -17,9 +17,10 @@
   Calibration Process:
   1. User initiates calibration ('c' command)
   2. Set pot to minimum position
-  3. System reads minimum value (10-sample average)
+  3. System reads minimum value (10-sample median) while the
+     loop keeps running
   4. Set pot to maximum position
-  5. System reads maximum value (10-sample average)
+  5. System reads maximum value (10-sample median)
   6. Values are saved to flash memory
 
   Calibration Parameters:
@@ -56,6 +57,7 @@
 */
 
 #include <CalibrationLib.h>
+#include <CalibrationWorkflow.h>
 
 CalibrationLib calibration;
 
@@ -67,6 +69,16 @@ int minValue = 0;
 int maxValue = 4095;
 float outputScale = 100.0; // Scale to 0-100%
 
+// Linear min/max mapping, precomputed for every 12-bit reading. The table
+// rebuilds itself the next time it is used after the transform changes.
+CalibrationTransform potTransform;
+CalibrationLUT potTable;
+
+void updateTransform() {
+  float scale = outputScale / (maxValue - minValue);
+  potTransform.setLinear(scale, -minValue * scale);
+}
+
 void setup() {
   Serial.begin(115200);
   delay(1000);
@@ -93,47 +105,46 @@ void setup() {
     Serial.println("No calibration found. Using defaults");
   }
   
+  updateTransform();
+  if (!potTable.build(potTransform, 12)) {
+    Serial.println("Not enough memory for lookup table!");
+  }
+  
   Serial.println("\nCommands:");
   Serial.println("'c' - Start calibration");
   Serial.println("'r' - Reset to defaults");
   Serial.println("'p' - Print current values");
 }
 
+float readPot(void* context) {
+  return analogRead(POT_PIN);
+}
+
+// Each end point is the median of 10 readings taken 50ms apart
+RobustAggregator<10> endPointSamples;
+const WorkflowStep steps[] = {
+  {"Turn potentiometer to minimum position, then press ENTER", 0.0f, 0, 10},
+  {"Turn potentiometer to maximum position, then press ENTER", 100.0f, 0, 10},
+};
+CalibrationWorkflow workflow(calibration, "pot_model", readPot);
+
 void calibratePotentiometer() {
   Serial.println("\nStarting calibration...");
-  Serial.println("1. Turn potentiometer to minimum position");
-  Serial.println("2. Press ENTER when ready");
-  
-  while (Serial.read() != '\n') {
-    delay(10);
-  }
-  
-  // Read minimum value (average of 10 readings)
-  minValue = 0;
-  for (int i = 0; i < 10; i++) {
-    minValue += analogRead(POT_PIN);
-    delay(50);
-  }
-  minValue /= 10;
-  
-  Serial.println("3. Turn potentiometer to maximum position");
-  Serial.println("4. Press ENTER when ready");
-  
-  while (Serial.read() != '\n') {
-    delay(10);
-  }
-  
-  // Read maximum value (average of 10 readings)
-  maxValue = 0;
-  for (int i = 0; i < 10; i++) {
-    maxValue += analogRead(POT_PIN);
-    delay(50);
-  }
-  maxValue /= 10;
+  workflow.setSampleInterval(50);
+  workflow.setAggregator(&endPointSamples, ROBUST_MEDIAN);
+  workflow.start(steps, 2);
+}
+
+// Converts the fitted 0-100% line back to raw end points
+void finishCalibration() {
+  const CalibrationTransform& fitted = workflow.transform();
+  minValue = lroundf(-fitted.offset() / fitted.scale());
+  maxValue = lroundf((outputScale - fitted.offset()) / fitted.scale());
   
   // Save calibration
   calibration.setCalibrationValue("min_val", minValue);
   calibration.setCalibrationValue("max_val", maxValue);
+  updateTransform();
   
   Serial.println("Calibration complete!");
   printValues();
@@ -144,6 +155,7 @@ void resetCalibration() {
   maxValue = 4095;
   calibration.setCalibrationValue("min_val", minValue);
   calibration.setCalibrationValue("max_val", maxValue);
+  updateTransform();
   Serial.println("Reset to default values");
   printValues();
 }
@@ -159,6 +171,12 @@ void printValues() {
 void loop() {
   if (Serial.available()) {
     char cmd = Serial.read();
+    if (workflow.isActive()) {
+      if (cmd == '\n') {
+        workflow.confirm();
+      }
+      cmd = 0;
+    }
     switch (cmd) {
       case 'c':
         calibratePotentiometer();
@@ -172,9 +190,14 @@ void loop() {
     }
   }
   
+  // Calibration steps advance here without blocking the readings below
+  if (workflow.isActive() && workflow.tick() == WORKFLOW_DONE) {
+    finishCalibration();
+  }
+  
   // Read and scale the potentiometer value
   int rawValue = analogRead(POT_PIN);
-  float scaledValue = map(rawValue, minValue, maxValue, 0, outputScale);
+  float scaledValue = potTable.apply(rawValue);
   scaledValue = constrain(scaledValue, 0, outputScale);
   
   // Print values every second
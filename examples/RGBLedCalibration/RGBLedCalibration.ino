@@ -8,8 +8,11 @@
 
   Features:
   - Individual RGB channel calibration
+  - Gamma correction for perceptually even brightness steps
+  - Calibration compiled into integer PWM lookup tables
   - Real-time color updates
   - White balance testing
+  - Smooth color fade animation
   - Persistent calibration storage
   - Interactive serial interface
   - PWM-based LED control
@@ -27,6 +30,10 @@
      - Adjusts blue channel intensity
      - Default: 1.0
 
+  4. Gamma (1.0 - 3.0)
+     - Maps 8-bit color levels to LED duty
+     - Default: 2.2
+
   Hardware Setup:
   - ESP32 development board
   - Common Cathode RGB LED:
@@ -37,20 +44,25 @@
 
   PWM Configuration:
   - Frequency: 5000 Hz
-  - Resolution: 8-bit (0-255)
+  - Resolution: 12-bit (0-4095), so dim gamma-corrected levels
+    stay distinct
   - Channels: R=0, G=1, B=2
 
   Serial Commands:
   - 'r': Adjust red factor
   - 'g': Adjust green factor
   - 'b': Adjust blue factor
+  - 'y': Adjust gamma
   - 'w': Run white balance test
+  - 'a': Run a color fade animation
   - 's': Save calibration
   - 'p': Print current values
 
   Storage:
   - Namespace: "rgb_cal"
-  - Keys: "red_factor", "green_factor", "blue_factor"
+  - Key: "led_color" (gains, gamma and matrix in one entry)
+  - Older "red_factor", "green_factor", "blue_factor" keys are
+    read once as the initial gains
 
   Note: Resistor values may need adjustment based on your
   specific LED specifications. Typical values range from
@@ -79,12 +91,24 @@ const int PWM_CHANNEL_R = 0;
 const int PWM_CHANNEL_G = 1;
 const int PWM_CHANNEL_B = 2;
 const int PWM_FREQ = 5000;
-const int PWM_RESOLUTION = 8; // 8-bit resolution (0-255)
+const int PWM_RESOLUTION = 12; // 12-bit resolution (0-4095)
 
 // Calibration factors (0.0 - 1.0)
 float redFactor = 1.0;
 float greenFactor = 1.0;
 float blueFactor = 1.0;
+float ledGamma = 2.2;
+
+// Color model and the PWM tables compiled from it
+ColorCalibration ledModel;
+ColorLUT ledTable;
+
+// Recompiles the tables; call after any factor changes
+void updateColorTable() {
+  ledModel.setGain(redFactor, greenFactor, blueFactor);
+  ledModel.setGamma(ledGamma);
+  ledTable.build(ledModel, PWM_RESOLUTION);
+}
 
 void setup() {
   Serial.begin(115200);
@@ -109,22 +133,31 @@ void setup() {
   }
   
   // Load existing calibration if available
-  if (calibration.hasCalibrationValue("red_factor") && 
+  if (calibration.loadColorCalibration("led_color", ledModel) == CAL_OK) {
+    redFactor = ledModel.gain()[0];
+    greenFactor = ledModel.gain()[1];
+    blueFactor = ledModel.gain()[2];
+    ledGamma = ledModel.gamma()[0];
+    Serial.println("Loaded existing calibration values");
+  } else if (calibration.hasCalibrationValue("red_factor") && 
       calibration.hasCalibrationValue("green_factor") &&
       calibration.hasCalibrationValue("blue_factor")) {
     calibration.getCalibrationValue("red_factor", redFactor);
     calibration.getCalibrationValue("green_factor", greenFactor);
     calibration.getCalibrationValue("blue_factor", blueFactor);
-    Serial.println("Loaded existing calibration values");
+    Serial.println("Loaded channel factors from an older version");
   } else {
     Serial.println("No calibration found. Using defaults");
   }
+  updateColorTable();
   
   Serial.println("\nCommands:");
   Serial.println("'r' - Adjust red factor");
   Serial.println("'g' - Adjust green factor");
   Serial.println("'b' - Adjust blue factor");
+  Serial.println("'y' - Adjust gamma");
   Serial.println("'w' - Test white balance");
+  Serial.println("'a' - Run color fade");
   Serial.println("'s' - Save current calibration");
   Serial.println("'p' - Print current values");
 }
@@ -162,17 +195,39 @@ void adjustColor(char color) {
   
   if (newFactor >= 0.0 && newFactor <= 1.0) {
     *factor = newFactor;
+    updateColorTable();
     Serial.printf("%s factor set to %.2f\n", name, *factor);
   } else {
     Serial.println("Invalid value! Factor must be between 0.0 and 1.0");
   }
 }
 
+void adjustGamma() {
+  Serial.printf("\nAdjusting gamma (current: %.2f)\n", ledGamma);
+  Serial.println("Enter new gamma (1.0 - 3.0):");
+  
+  while (!Serial.available()) {
+    delay(10);
+  }
+  
+  String input = Serial.readStringUntil('\n');
+  float newGamma = input.toFloat();
+  
+  if (newGamma >= 1.0 && newGamma <= 3.0) {
+    ledGamma = newGamma;
+    updateColorTable();
+    Serial.printf("Gamma set to %.2f\n", ledGamma);
+  } else {
+    Serial.println("Invalid value! Gamma must be between 1.0 and 3.0");
+  }
+}
+
 void saveCalibration() {
-  calibration.setCalibrationValue("red_factor", redFactor);
-  calibration.setCalibrationValue("green_factor", greenFactor);
-  calibration.setCalibrationValue("blue_factor", blueFactor);
-  Serial.println("Calibration saved!");
+  if (calibration.storeColorCalibration("led_color", ledModel) == CAL_OK) {
+    Serial.println("Calibration saved!");
+  } else {
+    Serial.println("Failed to save calibration!");
+  }
 }
 
 void printValues() {
@@ -180,13 +235,16 @@ void printValues() {
   Serial.printf("Red: %.2f\n", redFactor);
   Serial.printf("Green: %.2f\n", greenFactor);
   Serial.printf("Blue: %.2f\n", blueFactor);
+  Serial.printf("Gamma: %.2f\n", ledGamma);
 }
 
-void setColor(int r, int g, int b) {
-  // Apply calibration factors
-  ledcWrite(PWM_CHANNEL_R, r * redFactor);
-  ledcWrite(PWM_CHANNEL_G, g * greenFactor);
-  ledcWrite(PWM_CHANNEL_B, b * blueFactor);
+void setColor(uint8_t r, uint8_t g, uint8_t b) {
+  // Gain and gamma are already in the tables: three loads, no float math
+  uint16_t duty[3];
+  ledTable.apply(r, g, b, duty);
+  ledcWrite(PWM_CHANNEL_R, duty[0]);
+  ledcWrite(PWM_CHANNEL_G, duty[1]);
+  ledcWrite(PWM_CHANNEL_B, duty[2]);
 }
 
 void testWhiteBalance() {
@@ -213,6 +271,28 @@ void testWhiteBalance() {
   setColor(0, 0, 0);
 }
 
+// Fades around the color wheel at about 1000 frames per second
+void runFade() {
+  Serial.println("Running color fade...");
+  unsigned long start = millis();
+  uint32_t frames = 0;
+  while (millis() - start < 3000) {
+    uint8_t hue = (millis() - start) * 256 * 3 / 3000;   // three turns
+    uint8_t rise = (hue % 85) * 3;
+    if (hue < 85) {
+      setColor(255 - rise, rise, 0);
+    } else if (hue < 170) {
+      setColor(0, 255 - rise, rise);
+    } else {
+      setColor(rise, 0, 255 - rise);
+    }
+    frames++;
+    delayMicroseconds(1000);
+  }
+  setColor(0, 0, 0);
+  Serial.printf("%lu frames in 3s\n", (unsigned long)frames);
+}
+
 void loop() {
   if (Serial.available()) {
     char cmd = Serial.read();
@@ -222,9 +302,15 @@ void loop() {
       case 'b':
         adjustColor(cmd);
         break;
+      case 'y':
+        adjustGamma();
+        break;
       case 'w':
         testWhiteBalance();
         break;
+      case 'a':
+        runFade();
+        break;
       case 's':
         saveCalibration();
         break;
@@ -9,11 +9,12 @@
   - Persistent storage of calibration data
   - Real-time sensor reading with calibration applied
   - Option to recalibrate existing sensors
+  - Non-blocking workflow: the loop keeps running between steps
 
   Features:
-  - Interactive calibration wizard
+  - Interactive calibration wizard (CalibrationWorkflow)
   - Zero-point calibration
-  - Scale factor calculation
+  - Scale factor calculation from a fitted line
   - Maximum value adjustment
   - Persistent calibration storage
   - Real-time calibrated readings
@@ -21,19 +22,19 @@
   - User-friendly serial interface
 
   Calibration Process:
-  1. Zero Point Calibration
+  1. Scale Factor Configuration (optional)
+     - Set desired maximum output value with 'm<value>'
+  2. Zero Point Calibration
      - Set sensor to minimum position
-     - Record baseline reading
-  2. Maximum Value Calibration
+     - Record baseline reading (20 samples)
+  3. Maximum Value Calibration
      - Set sensor to maximum position
-     - Record peak reading
-  3. Scale Factor Configuration
-     - Set desired maximum output value
-     - Automatically calculate scale factor
+     - Record peak reading (20 samples)
+  4. Automatic Calculation
+     - Fit the linear model and store it
 
   Calibration Parameters:
-  - zero: Sensor reading at minimum position
-  - scale: Multiplication factor for scaling
+  - model: Linear transform from raw reading to output
   - max: Desired maximum output value
 
   Hardware Setup:
@@ -42,10 +43,11 @@
   - Serial connection for interaction (115200 baud)
 
   Serial Interface Commands:
-  - 'y': Start recalibration process
-  - 'n': Skip recalibration
-  - Any key: Proceed through calibration steps
-  - Enter number: Set maximum output value
+  - 'c': Start (re)calibration process
+  - 'x': Cancel a running calibration
+  - Enter: Confirm the current calibration step
+  - 'm<number>': Set maximum output value, e.g. m1023
+  - 'p': Print current calibration
 
   Dependencies:
   - ESP32 Arduino Core
@@ -62,17 +64,30 @@
 
 
 #include <CalibrationLib.h>
+#include <CalibrationWorkflow.h>
 
 CalibrationLib calibration;
 
 // Calibration parameters
-int zeroPoint = 0;
-float scaleFactor = 1.0;
+CalibrationTransform model;
 int maxValue = 1023;
 
 // Simulated sensor pin
 const int sensorPin = 36; // ADC pin on ESP32
 
+float readSensor(void* context) {
+  return analogRead(sensorPin);
+}
+
+// Step references are filled in from maxValue when calibration starts
+WorkflowStep steps[] = {
+  {"Set sensor to minimum position/value and press Enter", 0.0f, 500, 20},
+  {"Set sensor to maximum position/value and press Enter", 1023.0f, 500, 20},
+};
+CalibrationWorkflow workflow(calibration, "model", readSensor);
+
+unsigned long lastPrint = 0;
+
 void setup() {
   Serial.begin(115200);
   delay(1000); // Give time to open serial monitor
@@ -87,38 +102,41 @@ void setup() {
   }
   
   // Check if calibration data exists
-  if (calibration.hasCalibrationValue("zero") && 
-      calibration.hasCalibrationValue("scale") &&
-      calibration.hasCalibrationValue("max")) {
-    
-    // Load existing calibration
-    loadCalibrationData();
-    
+  if (calibration.loadTransform("model", model) == CAL_OK) {
+    calibration.getCalibrationValue("max", maxValue, maxValue);
     Serial.println("Existing calibration loaded.");
     printCalibrationValues();
-    
-    // Ask if user wants to recalibrate
-    Serial.println("\nDo you want to recalibrate? (y/n)");
-    while (!Serial.available()) {
-      // Wait for input
-    }
-    
-    if (Serial.read() == 'y') {
-      performCalibration();
-    }
   } else {
     Serial.println("No calibration data found. Starting calibration process...");
-    performCalibration();
+    startCalibration();
   }
   
-  Serial.println("\nCalibration complete. Now reading sensor values...");
-  Serial.println("Press any key to end the program.");
+  Serial.println("\nCommands: 'c' calibrate, 'x' cancel, 'm<value>' set maximum, 'p' print");
 }
 
 void loop() {
-  // Read and display calibrated sensor values
+  handleSerial();
+  
+  // Advances the calibration without blocking; other work continues below
+  if (workflow.isActive()) {
+    WorkflowState state = workflow.tick();
+    if (state == WORKFLOW_DONE) {
+      model = workflow.transform();
+      calibration.setCalibrationValue("max", maxValue);
+      Serial.println("\nCalibration completed and saved!");
+      printCalibrationValues();
+    }
+    return;
+  }
+  
+  // Read and display calibrated sensor values every half second
+  if (millis() - lastPrint < 500) {
+    return;
+  }
+  lastPrint = millis();
+  
   int rawValue = analogRead(sensorPin);
-  float calibratedValue = ((float)rawValue - zeroPoint) * scaleFactor;
+  float calibratedValue = model.apply(rawValue);
   
   // Constrain to valid range
   if (calibratedValue < 0) calibratedValue = 0;
@@ -128,85 +146,42 @@ void loop() {
   Serial.print(rawValue);
   Serial.print("\tCalibrated: ");
   Serial.println(calibratedValue, 2);
-  
-  // Check if user wants to end
-  if (Serial.available()) {
-    calibration.end();
-    Serial.println("\nProgram ended. Calibration data saved.");
-    while(1); // Stop execution
-  }
-  
-  delay(500); // Update every half second
 }
 
-void performCalibration() {
-  Serial.println("\n--- Starting Calibration Process ---");
-  
-  // Step 1: Zero point calibration
-  Serial.println("\nStep 1: Zero Point Calibration");
-  Serial.println("Set sensor to minimum position/value and press any key...");
-  waitForSerialInput();
-  
-  zeroPoint = analogRead(sensorPin);
-  Serial.print("Zero point set to: ");
-  Serial.println(zeroPoint);
-  
-  // Step 2: Maximum value calibration
-  Serial.println("\nStep 2: Maximum Value Calibration");
-  Serial.println("Set sensor to maximum position/value and press any key...");
-  waitForSerialInput();
-  
-  int maxReading = analogRead(sensorPin);
-  Serial.print("Maximum reading: ");
-  Serial.println(maxReading);
-  
-  // Step 3: Set desired maximum output value
-  Serial.println("\nStep 3: Set Desired Maximum Output Value");
-  Serial.println("Enter the desired maximum output value (default=1023):");
-  
-  while (!Serial.available()) {
-    // Wait for input
+void handleSerial() {
+  if (!Serial.available()) {
+    return;
   }
   
   String input = Serial.readStringUntil('\n');
-  if (input.length() > 0) {
-    maxValue = input.toInt();
+  input.trim();
+  if (input.length() == 0) {
+    workflow.confirm();
+  } else if (input == "c" && !workflow.isActive()) {
+    startCalibration();
+  } else if (input == "x") {
+    workflow.cancel();
+  } else if (input == "p") {
+    printCalibrationValues();
+  } else if (input.startsWith("m") && input.length() > 1 && !workflow.isActive()) {
+    maxValue = input.substring(1).toInt();
+    Serial.print("Maximum output value set to: ");
+    Serial.println(maxValue);
   }
-  
-  // Calculate scale factor
-  scaleFactor = (float)maxValue / (maxReading - zeroPoint);
-  
-  // Save calibration data
-  saveCalibrationData();
-  
-  Serial.println("\nCalibration completed and saved!");
-  printCalibrationValues();
 }
 
-void saveCalibrationData() {
-  calibration.setCalibrationValue("zero", zeroPoint);
-  calibration.setCalibrationValue("scale", scaleFactor);
-  calibration.setCalibrationValue("max", maxValue);
-}
-
-void loadCalibrationData() {
-  calibration.getCalibrationValue("zero", zeroPoint);
-  calibration.getCalibrationValue("scale", scaleFactor);
-  calibration.getCalibrationValue("max", maxValue);
+void startCalibration() {
+  Serial.println("\n--- Starting Calibration Process ---");
+  steps[1].reference = maxValue;
+  workflow.start(steps, 2);
 }
 
 void printCalibrationValues() {
   Serial.println("\nCurrent Calibration Values:");
   Serial.print("Zero Point: ");
-  Serial.println(zeroPoint);
+  Serial.println(model.scale() != 0 ? -model.offset() / model.scale() : 0.0f, 1);
   Serial.print("Scale Factor: ");
-  Serial.println(scaleFactor, 6);
+  Serial.println(model.scale(), 6);
   Serial.print("Maximum Value: ");
   Serial.println(maxValue);
 }
-
-void waitForSerialInput() {
-  while (Serial.available()) { Serial.read(); } // Clear buffer
-  while (!Serial.available()) { delay(10); } // Wait for new input
-  while (Serial.available()) { Serial.read(); } // Clear again
-}
\ No newline at end of file
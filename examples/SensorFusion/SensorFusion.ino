@@ -6,18 +6,23 @@
   data for multiple sensors simultaneously, combining environmental and
   motion sensing. It shows how to:
   - Calibrate multiple sensors in a single workflow
-  - Store complex calibration data using JSON
+  - Store 3-axis calibration models as compact binary entries
   - Apply calibration corrections in real-time
   - Version and timestamp calibration data
 
   Features:
   - Multi-sensor calibration management
-  - JSON-based array storage
-  - Automatic offset calculation
+  - Automatic offset calculation without blocking the main loop
+  - Median offsets, so a single glitched reading is ignored
+  - Six-position accelerometer calibration (bias, scale, misalignment)
   - Real-time calibration application
   - Calibration versioning
   - Timestamp tracking
   - Debug level control
+  - Boot-time calibration load profiling
+  - Drift monitoring with a prioritized recalibration schedule
+  - Kalman-fused roll, pitch and temperature with stored noise
+    tuning and checkpointed state for warm starts
 
   Sensors:
   1. BME280 Environmental Sensor
@@ -29,13 +34,16 @@
      - Gyroscope (rad/s)
 
   Calibration Process:
-  - Collects 100 samples from each sensor
-  - Calculates offsets against reference values:
+  - Collects 100 samples from each sensor, one per 10ms loop pass,
+    while normal readings keep printing
+  - Calculates offsets from each channel's median against
+    reference values:
     * Temperature: 25°C
     * Humidity: 50%
     * Pressure: 1013.25 hPa
-    * Accelerometer: 0 m/s² (gravity compensated)
-    * Gyroscope: 0 rad/s
+    * Gyroscope: 0 rad/s (bias)
+  - Accelerometer: 100 samples resting on each of six faces,
+    fitted against ±1 g on the upward axis
 
   Hardware Setup:
   - ESP32 development board
@@ -47,10 +55,14 @@
 
   Serial Interface:
   - Baud Rate: 115200
-  - Command 'c': Start calibration process
+  - Command 'c': Start offset calibration process
+  - Command 'o': Capture the current accelerometer face
+  - Command 'r': Restart the six-face capture
+  - Command 'd': Print the drift report
   - Output Format:
     * Environmental: Temperature, Humidity, Pressure
     * Motion: Acceleration (XYZ), Gyroscope (XYZ)
+    * Fused: Roll, pitch, gyro bias estimate and temperature
 
   Dependencies:
   - ESP32 Arduino Core
@@ -76,103 +88,257 @@
 CalibrationLib calibration;
 Adafruit_BME280 bme;
 Adafruit_MPU6050 mpu;
+BootProfiler bootProfile;
+
+// Running statistics for each input while calibrating:
+// temperature, humidity, pressure, accel XYZ, gyro XYZ
+const int CHANNELS = 9;
+const uint32_t CALIBRATION_SAMPLES = 100;
+SampleAccumulator samples[CHANNELS];
+// Raw samples kept for the median of the offset channels
+RobustAggregator<CALIBRATION_SAMPLES> envSamples[3];
+RobustAggregator<CALIBRATION_SAMPLES> gyroSamples[3];
+bool calibrating = false;
+unsigned long lastSample = 0;
+unsigned long lastPrint = 0;
+
+// Reference values the offsets correct towards
+const char* const envKeys[] = {"temp_offset", "humidity_offset", "pressure_offset"};
+const float envReferences[] = {25.0f, 50.0f, 1013.25f};   // °C, %, hPa
 
 // Calibration offsets
 float tempOffset = 0.0f;
 float humidityOffset = 0.0f;
 float pressureOffset = 0.0f;
-float accelOffset[3] = {0.0f, 0.0f, 0.0f};
-float gyroOffset[3] = {0.0f, 0.0f, 0.0f};
+
+// 3-axis models: corrected = matrix * (raw - bias)
+AxisCalibration accelModel;
+AxisCalibration gyroModel;
+AxisCalibrationFitter accelFitter;
+bool capturingFace = false;
+
+// Drift checks taken whenever the board is still: the gyro should read
+// zero, the accelerometer 1 g, and both temperature sensors should agree.
+// Tolerances are in output units; operating time is stored with each
+// monitor, so the schedule carries over reboots.
+DriftMonitor gyroDrift(0.02f);      // rad/s
+DriftMonitor accelDrift(0.15f);     // m/s²
+DriftMonitor tempDrift(2.0f);       // °C, MPU6050 die vs BME280
+DriftMonitor* const driftMonitors[] = {&gyroDrift, &accelDrift, &tempDrift};
+const char* const driftKeys[] = {"drift_gyro", "drift_accel", "drift_temp"};
+RecalibrationScheduler scheduler;
+unsigned long lastDriftSave = 0;
+
+// Roll and pitch each track [angle, gyro bias]: the gyro drives the
+// prediction and the accelerometer's gravity angle corrects it. The
+// temperature filter fuses both sensors into one estimate. The noise
+// tuning is calibration data; the state is checkpointed with the drift
+// monitors so a reboot resumes with the learned gyro bias.
+const float FUSION_DT = 0.01f;   // s, one fusion step per 10ms
+KalmanFilter<2, 1> rollFilter;
+KalmanFilter<2, 1> pitchFilter;
+KalmanFilter<1, 2> tempFilter;
 
 void loadCalibration() {
     calibration.getCalibrationValue("temp_offset", tempOffset);
     calibration.getCalibrationValue("humidity_offset", humidityOffset);
     calibration.getCalibrationValue("pressure_offset", pressureOffset);
     
-    String jsonOffsets;
-    if (calibration.getCalibrationValue("accel_offset", jsonOffsets)) {
-        StaticJsonDocument<200> doc;
-        deserializeJson(doc, jsonOffsets);
-        accelOffset[0] = doc[0];
-        accelOffset[1] = doc[1];
-        accelOffset[2] = doc[2];
+    calibration.loadAxisCalibration("accel_model", accelModel);
+    calibration.loadAxisCalibration("gyro_model", gyroModel);
+    
+    for (int i = 0; i < 3; i++) {
+        calibration.loadDriftMonitor(driftKeys[i], *driftMonitors[i]);
+    }
+}
+
+void setupFusion() {
+    const float F[] = {1.0f, -FUSION_DT, 0.0f, 1.0f};
+    const float H[] = {1.0f, 0.0f};
+    const float Q[] = {1e-5f, 0.0f, 0.0f, 1e-8f};   // angle, bias random walk
+    KalmanFilterBase* const tilt[] = {&rollFilter, &pitchFilter};
+    for (int i = 0; i < 2; i++) {
+        tilt[i]->setTransition(F);
+        tilt[i]->setObservation(H);
+        tilt[i]->setProcessNoise(Q);
+        tilt[i]->setMeasurementNoise(3e-3f);           // rad², accel angle
     }
     
-    if (calibration.getCalibrationValue("gyro_offset", jsonOffsets)) {
-        StaticJsonDocument<200> doc;
-        deserializeJson(doc, jsonOffsets);
-        gyroOffset[0] = doc[0];
-        gyroOffset[1] = doc[1];
-        gyroOffset[2] = doc[2];
+    // Both sensors observe the same temperature; the MPU6050 die reading
+    // is the noisier one
+    const float tempH[] = {1.0f, 1.0f};
+    const float tempR[] = {0.04f, 0.0f, 0.0f, 0.25f};  // °C²
+    tempFilter.setObservation(tempH);
+    tempFilter.setMeasurementNoise(tempR);
+    tempFilter.setProcessNoise(1e-4f);
+    
+    // Stored tuning overrides the defaults above; a checkpoint resumes the
+    // filters where they left off
+    calibration.loadKalmanTuning("roll_kf_tune", rollFilter);
+    calibration.loadKalmanTuning("pitch_kf_tune", pitchFilter);
+    calibration.loadKalmanTuning("temp_kf_tune", tempFilter);
+    calibration.loadKalmanState("roll_kf", rollFilter);
+    calibration.loadKalmanState("pitch_kf", pitchFilter);
+    calibration.loadKalmanState("temp_kf", tempFilter);
+}
+
+// Called every 10ms from loop() when not calibrating
+void updateOrientation() {
+    sensors_event_t a, g, temp;
+    mpu.getEvent(&a, &g, &temp);
+    float accel[3] = {a.acceleration.x, a.acceleration.y, a.acceleration.z};
+    float gyro[3] = {g.gyro.x, g.gyro.y, g.gyro.z};
+    accelModel.apply(accel, accel);
+    gyroModel.apply(gyro, gyro);
+    
+    float roll = atan2f(accel[1], accel[2]);
+    float pitch = atan2f(-accel[0], sqrtf(accel[1] * accel[1] + accel[2] * accel[2]));
+    float rollControl[] = {gyro[0] * FUSION_DT, 0.0f};
+    float pitchControl[] = {gyro[1] * FUSION_DT, 0.0f};
+    rollFilter.predict(rollControl);
+    rollFilter.update(&roll);
+    pitchFilter.predict(pitchControl);
+    pitchFilter.update(&pitch);
+}
+
+void saveDriftMonitors() {
+    calibration.batchBegin();
+    for (int i = 0; i < 3; i++) {
+        calibration.storeDriftMonitor(driftKeys[i], *driftMonitors[i]);
+    }
+    calibration.storeKalmanState("roll_kf", rollFilter);
+    calibration.storeKalmanState("pitch_kf", pitchFilter);
+    calibration.storeKalmanState("temp_kf", tempFilter);
+    calibration.batchCommit();
+}
+
+// Residuals against known references, only while nothing is moving
+void checkDrift(const float accel[3], const float gyro[3], float temperature, float mpuTemperature) {
+    float rate = sqrtf(gyro[0] * gyro[0] + gyro[1] * gyro[1] + gyro[2] * gyro[2]);
+    if (rate > 0.1f) {
+        return;
     }
+    gyroDrift.addCheck(rate, 0.0f);
+    accelDrift.addCheck(sqrtf(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2]), 9.80665f);
+    tempDrift.addAgreement(temperature, mpuTemperature);
 }
 
 void saveCalibration() {
-    calibration.setCalibrationValue("temp_offset", tempOffset);
-    calibration.setCalibrationValue("humidity_offset", humidityOffset);
-    calibration.setCalibrationValue("pressure_offset", pressureOffset);
-    
-    StaticJsonDocument<200> doc;
-    String jsonString;
-    
-    // Save accelerometer offsets
-    doc.clear();
-    doc.add(accelOffset[0]);
-    doc.add(accelOffset[1]);
-    doc.add(accelOffset[2]);
-    serializeJson(doc, jsonString);
-    calibration.setCalibrationValue("accel_offset", jsonString.c_str());
-    
-    // Save gyroscope offsets
-    doc.clear();
-    doc.add(gyroOffset[0]);
-    doc.add(gyroOffset[1]);
-    doc.add(gyroOffset[2]);
-    serializeJson(doc, jsonString);
-    calibration.setCalibrationValue("gyro_offset", jsonString.c_str());
+    // One batch for all keys; the scalar offsets come straight from the medians
+    calibration.batchBegin();
+    for (int i = 0; i < 3; i++) {
+        calibration.storeOffset(envKeys[i], envSamples[i], envReferences[i], ROBUST_MEDIAN);
+    }
+    calibration.storeAxisCalibration("gyro_model", gyroModel);
     
     // Set version and timestamp
     calibration.setCalibrationVersion("1.0");
     calibration.setCalibrationTimestamp();
+    calibration.batchCommit();
 }
 
-void calibrateSensors() {
+void startCalibration() {
     Serial.println("Starting sensor calibration...");
-    
-    // Collect multiple samples for averaging
-    const int samples = 100;
-    float temp_sum = 0, humidity_sum = 0, pressure_sum = 0;
-    float accel_sum[3] = {0}, gyro_sum[3] = {0};
-    
-    for (int i = 0; i < samples; i++) {
-        temp_sum += bme.readTemperature();
-        humidity_sum += bme.readHumidity();
-        pressure_sum += bme.readPressure() / 100.0F;
-        
-        sensors_event_t a, g, temp;
-        mpu.getEvent(&a, &g, &temp);
-        accel_sum[0] += a.acceleration.x;
-        accel_sum[1] += a.acceleration.y;
-        accel_sum[2] += a.acceleration.z - 9.81; // Remove gravity
-        gyro_sum[0] += g.gyro.x;
-        gyro_sum[1] += g.gyro.y;
-        gyro_sum[2] += g.gyro.z;
-        
-        delay(10);
+    for (int i = 0; i < CHANNELS; i++) {
+        samples[i].reset();
+        samples[i].setTarget(CALIBRATION_SAMPLES);
+    }
+    for (int i = 0; i < 3; i++) {
+        envSamples[i].reset();
+        gyroSamples[i].reset();
     }
+    calibrating = true;
+}
+
+// Averages the accelerometer while the board rests on one face
+void startFaceCapture() {
+    Serial.println("Capturing orientation, keep the board still...");
+    for (int i = 3; i < 6; i++) {
+        samples[i].reset();
+        samples[i].setTarget(CALIBRATION_SAMPLES);
+    }
+    capturingFace = true;
+}
+
+// Called every 10ms from loop() while calibrating
+void sampleSensors() {
+    sensors_event_t a, g, temp;
+    mpu.getEvent(&a, &g, &temp);
+    samples[3].add(a.acceleration.x);
+    samples[4].add(a.acceleration.y);
+    samples[5].add(a.acceleration.z);
     
-    // Calculate offsets
-    tempOffset = 25.0 - (temp_sum / samples); // Assuming 25°C as reference
-    humidityOffset = 50.0 - (humidity_sum / samples); // Assuming 50% as reference
-    pressureOffset = 1013.25 - (pressure_sum / samples); // Assuming 1013.25 hPa as reference
+    if (capturingFace) {
+        if (samples[3].isReady() && samples[4].isReady() && samples[5].isReady()) {
+            finishFaceCapture();
+        }
+        return;
+    }
     
+    float env[3] = {bme.readTemperature(), bme.readHumidity(), bme.readPressure() / 100.0F};
+    float gyro[3] = {g.gyro.x, g.gyro.y, g.gyro.z};
     for (int i = 0; i < 3; i++) {
-        accelOffset[i] = -(accel_sum[i] / samples);
-        gyroOffset[i] = -(gyro_sum[i] / samples);
+        samples[i].add(env[i]);
+        samples[6 + i].add(gyro[i]);
+        envSamples[i].add(env[i]);
+        gyroSamples[i].add(gyro[i]);
     }
     
+    for (int i = 0; i < CHANNELS; i++) {
+        if (!samples[i].isReady()) {
+            return;
+        }
+    }
+    finishCalibration();
+}
+
+void finishCalibration() {
+    calibrating = false;
+    
+    // Calculate offsets
+    tempOffset = envSamples[0].offsetTo(envReferences[0]);
+    humidityOffset = envSamples[1].offsetTo(envReferences[1]);
+    pressureOffset = envSamples[2].offsetTo(envReferences[2]);
+    
+    // A resting gyro should read zero, so its median is the bias
+    float gyroBias[3] = {gyroSamples[0].median(), gyroSamples[1].median(), gyroSamples[2].median()};
+    gyroModel.setBias(gyroBias);
+    
     saveCalibration();
-    Serial.println("Calibration complete!");
+    scheduler.markRecalibrated(scheduler.find("gyro"));
+    scheduler.markRecalibrated(scheduler.find("temp"));
+    saveDriftMonitors();
+    Serial.printf("Calibration complete! Gyro noise: %.4f %.4f %.4f rad/s\n",
+                  samples[6].stddev(), samples[7].stddev(), samples[8].stddev());
+}
+
+void finishFaceCapture() {
+    capturingFace = false;
+    
+    float mean[3] = {samples[3].mean(), samples[4].mean(), samples[5].mean()};
+    int8_t face = accelFitter.addGravitySample(mean, 9.80665f, samples[3].count());
+    
+    int seen = 0;
+    for (int bit = 0; bit < 6; bit++) {
+        seen += (accelFitter.facesSeen() >> bit) & 1;
+    }
+    Serial.printf("Captured %c%c face (%d of 6)\n", face > 0 ? '+' : '-', 'X' + abs(face) - 1, seen);
+    if (seen < 6) {
+        Serial.println("Rest the board on another face and enter 'o'");
+        return;
+    }
+    
+    // Bias, per-axis scale and misalignment from all six faces
+    float rms;
+    if (accelFitter.fit(accelModel, &rms)) {
+        calibration.storeAxisCalibration("accel_model", accelModel);
+        scheduler.markRecalibrated(scheduler.find("accel"));
+        saveDriftMonitors();
+        Serial.printf("Accelerometer calibrated, residual %.4f m/s²\n", rms);
+    } else {
+        Serial.println("Accelerometer fit failed, enter 'r' to restart");
+    }
+    accelFitter.reset();
 }
 
 void setup() {
@@ -189,22 +355,59 @@ void setup() {
         return;
     }
     
+    // Profile how long opening the namespace and loading each key takes
+    calibration.setTraceHook(BootProfiler::hook, &bootProfile);
     calibration.begin("sensor_fusion");
     calibration.setDebugLevel(DEBUG_INFO);
     
     loadCalibration();
+    calibration.setTraceHook(nullptr);
+    bootProfile.printReport(Serial);
+    
+    // The gyro drives orientation, so its drift counts double; the
+    // accelerometer is also refreshed after 30 days of operation
+    scheduler.addChannel("gyro", gyroDrift, 2);
+    scheduler.addChannel("accel", accelDrift, 1, 30UL * 86400UL);
+    scheduler.addChannel("temp", tempDrift);
     
-    Serial.println("Enter 'c' to calibrate sensors");
+    setupFusion();
+    
+    Serial.println("Enter 'c' to calibrate offsets (board flat and still)");
+    Serial.println("Enter 'o' on each of the six faces to calibrate the accelerometer");
 }
 
 void loop() {
     if (Serial.available()) {
         char cmd = Serial.read();
-        if (cmd == 'c') {
-            calibrateSensors();
+        if (cmd == 'c' && !calibrating && !capturingFace) {
+            startCalibration();
+        } else if (cmd == 'o' && !calibrating && !capturingFace) {
+            startFaceCapture();
+        } else if (cmd == 'r') {
+            accelFitter.reset();
+            Serial.println("Accelerometer capture restarted");
+        } else if (cmd == 'd') {
+            scheduler.printReport(Serial);
         }
     }
     
+    scheduler.update();
+    
+    if (millis() - lastSample >= 10) {
+        lastSample = millis();
+        if (calibrating || capturingFace) {
+            sampleSensors();
+        } else {
+            updateOrientation();
+        }
+    }
+    
+    // Print calibrated values once per second without blocking
+    if (millis() - lastPrint < 1000) {
+        return;
+    }
+    lastPrint = millis();
+    
     // Read and apply calibration
     float temperature = bme.readTemperature() + tempOffset;
     float humidity = bme.readHumidity() + humidityOffset;
@@ -213,21 +416,38 @@ void loop() {
     sensors_event_t a, g, temp;
     mpu.getEvent(&a, &g, &temp);
     
-    float accelX = a.acceleration.x + accelOffset[0];
-    float accelY = a.acceleration.y + accelOffset[1];
-    float accelZ = a.acceleration.z + accelOffset[2];
+    float accel[3] = {a.acceleration.x, a.acceleration.y, a.acceleration.z};
+    float gyro[3] = {g.gyro.x, g.gyro.y, g.gyro.z};
+    accelModel.apply(accel, accel);
+    gyroModel.apply(gyro, gyro);
+    
+    if (!calibrating && !capturingFace) {
+        checkDrift(accel, gyro, temperature, temp.temperature);
+    }
+    
+    const float temperatures[] = {temperature, temp.temperature};
+    tempFilter.predict();
+    tempFilter.update(temperatures);
     
-    float gyroX = g.gyro.x + gyroOffset[0];
-    float gyroY = g.gyro.y + gyroOffset[1];
-    float gyroZ = g.gyro.z + gyroOffset[2];
+    // Persist drift and filter state once a minute; name the most urgent channel
+    if (millis() - lastDriftSave >= 60000) {
+        lastDriftSave = millis();
+        saveDriftMonitors();
+        int8_t due = scheduler.next();
+        if (due >= 0) {
+            Serial.printf("Recalibration due: %s (%d channel(s) waiting)\n",
+                          scheduler.name(due), scheduler.dueCount());
+        }
+    }
     
     // Print calibrated values
     Serial.printf("Temperature: %.2f°C, Humidity: %.2f%%, Pressure: %.2fhPa\n",
                   temperature, humidity, pressure);
     Serial.printf("Accel X: %.2f, Y: %.2f, Z: %.2f m/s²\n",
-                  accelX, accelY, accelZ);
-    Serial.printf("Gyro X: %.2f, Y: %.2f, Z: %.2f rad/s\n\n",
-                  gyroX, gyroY, gyroZ);
-    
-    delay(1000);
+                  accel[0], accel[1], accel[2]);
+    Serial.printf("Gyro X: %.2f, Y: %.2f, Z: %.2f rad/s\n",
+                  gyro[0], gyro[1], gyro[2]);
+    Serial.printf("Fused roll: %.1f°, pitch: %.1f°, gyro bias X: %.4f, Y: %.4f rad/s, temperature: %.2f°C\n\n",
+                  rollFilter.state(0) * RAD_TO_DEG, pitchFilter.state(0) * RAD_TO_DEG,
+                  rollFilter.state(1), pitchFilter.state(1), tempFilter.state(0));
 }
\ No newline at end of file
@@ -11,21 +11,21 @@
   - Two-point calibration system
   - Automatic parameter calculation
   - Persistent calibration storage
-  - Averaged readings for accuracy
+  - Least-squares fit with RMS residual
   - Linear correction application
   - Calibration status tracking
-  - User-guided calibration process
+  - User-guided calibration process that never blocks loop()
 
   Calibration Process:
   1. Low Reference Point (0°C)
      - Uses ice water bath
-     - Takes 10 averaged readings
+     - Takes 10 readings after a 3s settle time
   2. High Reference Point (100°C)
      - Uses boiling water bath
-     - Takes 10 averaged readings
+     - Takes 10 readings after a 3s settle time
   3. Automatic Calculation
-     - Computes scale factor
-     - Determines offset value
+     - Fits a line through both averaged reference points
+     - Derives scale factor and offset value
 
   Calibration Parameters:
   - offset: Zero-point correction
@@ -52,7 +52,7 @@
   - Verify water bath temperatures with a reference thermometer
 
   Serial Interface:
-  - Press 'c' to start/continue calibration process
+  - Press 'c' to start calibration or confirm the current step
   - Continuous output of raw and calibrated readings
 
   Dependencies:
@@ -69,6 +69,7 @@
 */
 
 #include <CalibrationLib.h>
+#include <CalibrationWorkflow.h>
 
 CalibrationLib calibration;
 
@@ -86,6 +87,18 @@ const float REF_TEMP_HIGH = 100.0; // Boiling water reference (100°C)
 // Flag to track if calibration has been performed
 bool isCalibrated = false;
 
+float readRawTemperature(void* context = nullptr);
+
+// Each step averages 10 readings taken 100ms apart after a 3s settle time
+const WorkflowStep steps[] = {
+  {"Place the sensor in ice water (0°C), then press 'c'", REF_TEMP_LOW, 3000, 10},
+  {"Place the sensor in boiling water (100°C), then press 'c'. "
+   "WARNING: Be careful with boiling water!", REF_TEMP_HIGH, 3000, 10},
+};
+CalibrationWorkflow workflow(calibration, "model", readRawTemperature);
+
+unsigned long lastPrint = 0;
+
 void setup() {
   Serial.begin(115200);
   delay(1000); // Give time to open serial monitor
@@ -98,6 +111,7 @@ void setup() {
     Serial.println("Failed to initialize calibration library!");
     return;
   }
+  workflow.setSampleInterval(100);
   
   // Check if calibration data exists
   if (calibration.hasCalibrationValue("offset") && 
@@ -127,7 +141,24 @@ void setup() {
 }
 
 void loop() {
-  if (isCalibrated) {
+  if (Serial.available() && Serial.read() == 'c') {
+    if (workflow.isActive()) {
+      workflow.confirm();
+    } else {
+      startCalibrationProcess();
+    }
+  }
+  
+  if (workflow.isActive()) {
+    if (workflow.tick() == WORKFLOW_DONE) {
+      finishCalibrationProcess();
+    }
+    return;
+  }
+  
+  if (isCalibrated && millis() - lastPrint >= 1000) {
+    lastPrint = millis();
+    
     // Read and display calibrated temperature
     float rawTemp = readRawTemperature();
     float calibratedTemp = (rawTemp - offset) * scale;
@@ -137,43 +168,21 @@ void loop() {
     Serial.print(" | Temperature: ");
     Serial.print(calibratedTemp, 2);
     Serial.println(" °C");
-    
-    delay(1000);
-  } else {
-    // Check if user wants to start calibration
-    if (Serial.available() && Serial.read() == 'c') {
-      startCalibrationProcess();
-    }
   }
 }
 
 void startCalibrationProcess() {
   Serial.println("\n--- Starting Auto-Calibration Process ---");
   Serial.println("This process requires two reference temperature points.");
-  
-  // Step 1: Low temperature reference point (ice water, 0°C)
-  Serial.println("\nStep 1: Place the sensor in ice water (0°C).");
-  Serial.println("Press 'c' when ready...");
-  waitForKey('c');
-  
-  float lowReading = readAveragedRawTemperature(10);
-  Serial.print("Low reference reading: ");
-  Serial.println(lowReading);
-  
-  // Step 2: High temperature reference point (boiling water, 100°C)
-  Serial.println("\nStep 2: Place the sensor in boiling water (100°C).");
-  Serial.println("WARNING: Be careful with boiling water!");
-  Serial.println("Press 'c' when ready...");
-  waitForKey('c');
-  
-  float highReading = readAveragedRawTemperature(10);
-  Serial.print("High reference reading: ");
-  Serial.println(highReading);
-  
-  // Calculate calibration parameters
+  workflow.start(steps, 2);
+}
+
+// The workflow has fitted and stored the model; derive the legacy parameters
+void finishCalibrationProcess() {
   // For a linear sensor: temp = (raw - offset) * scale
-  scale = (REF_TEMP_HIGH - REF_TEMP_LOW) / (highReading - lowReading);
-  offset = lowReading - (REF_TEMP_LOW / scale);
+  const CalibrationTransform& model = workflow.transform();
+  scale = model.scale();
+  offset = -model.offset() / scale;
   
   // Save calibration data
   calibration.setCalibrationValue("offset", offset);
@@ -186,10 +195,13 @@ void startCalibrationProcess() {
   Serial.print(offset, 4);
   Serial.print(" | Scale: ");
   Serial.println(scale, 6);
+  Serial.print("RMS residual: ");
+  Serial.print(workflow.fitResult().rmse, 3);
+  Serial.println(" °C");
   Serial.println("\nReady to measure temperatures!");
 }
 
-float readRawTemperature() {
+float readRawTemperature(void* context) {
   // Read the analog value from the temperature sensor
   int adcValue = analogRead(tempSensorPin);
   
@@ -202,23 +214,3 @@ float readRawTemperature() {
   
   return rawTemp;
 }
-
-float readAveragedRawTemperature(int samples) {
-  float sum = 0.0;
-  for (int i = 0; i < samples; i++) {
-    sum += readRawTemperature();
-    delay(100);
-  }
-  return sum / samples;
-}
-
-void waitForKey(char key) {
-  while (Serial.available()) { Serial.read(); } // Clear buffer
-  char input = 0;
-  while (input != key) {
-    if (Serial.available()) {
-      input = Serial.read();
-    }
-    delay(10);
-  }
-}
\ No newline at end of file
@@ -19,6 +19,25 @@
   - Encrypted data storage
   - JSON data export
   - JSON data import
+  - Result-returning get/set
+  - Calibration transforms
+  - Compile-time calibrated channels
+  - Multi-channel calibration tables
+  - Sample accumulation
+  - Outlier-resistant aggregation
+  - 3-axis calibration
+  - Temperature compensation
+  - LED color correction
+  - Block acquisition pipeline
+  - Drift detection and recalibration scheduling
+  - Kalman filter fusion
+  - Calibration workflow
+  - Encrypted bundle export/import
+  - Deferred logging
+  - Latency histograms
+  - Operation counters and metrics output
+  - Trace hooks
+  - Boot-time load profiling
   - Error handling
   - Memory cleanup
 
@@ -43,6 +62,93 @@
      - Data import
      - Value verification
 
+  5. Result API Tests
+     - Value and status from one call
+     - Missing key reporting
+     - Shared error state untouched
+
+  6. Transform Tests
+     - Linear, polynomial and piecewise evaluation
+     - Batch, fixed-point and lookup table paths
+     - Least-squares fitting
+     - Transform storage round trip
+
+  7. Calibrated Channel Tests
+     - Specialized models against CalibrationTransform
+     - Integer output rounding and saturation
+     - Loading with model mismatch rejection
+
+  8. Calibration Table Tests
+     - Interleaved frame apply across channels
+     - Disabled channels
+     - Table storage round trip
+
+  9. Sample Accumulator Tests
+     - Running mean, variance and range
+     - Target and stability signalling
+     - Offset storage
+     - Median, trimmed mean and MAD rejection
+     - Streaming median
+
+  10. 3-Axis Calibration Tests
+     - Six-position fit of bias and scale
+     - Streaming ellipsoid (hard/soft iron) fit
+     - Model storage round trip
+
+  11. Temperature Compensation Tests
+     - Interpolated offset and scale
+     - Clamping outside the table
+     - Table storage round trip
+
+  12. Color Correction Tests
+     - Gain and gamma tables at PWM resolution
+     - White-balance matrix mixing
+     - Model storage round trip
+
+  13. Pipeline Tests
+     - Per-channel demultiplexing and batch calibration
+     - Ring buffer hand-off and overflow accounting
+
+  14. Drift Monitoring Tests
+     - Bias from reference and agreement checks
+     - Priority ranking of due channels
+     - Monitor storage round trip
+
+  15. Kalman Filter Tests
+     - Gyro bias estimation from tilt measurements
+     - Two-sensor measurement fusion
+     - Tuning and state storage round trip
+
+  16. Workflow Tests
+     - Prompt, settle and sample steps
+     - Fitted model committed to storage
+
+  17. Encrypted Bundle Tests
+     - Bundle export
+     - Tamper rejection
+     - Bundle import
+
+  18. Deferred Logging Tests
+     - Typed arguments formatted at drain time
+     - Dropped entries when the ring is full
+     - Concurrent producers with a draining consumer
+
+  19. Latency Histogram Tests
+     - Log2 bucket placement
+     - Percentile bounds
+
+  20. Metrics Tests
+     - Read, write and error counters
+     - Prometheus text and JSON output
+
+  21. Trace Hook Tests
+     - Begin/end pairing across nested operations
+     - Chrome trace event output
+
+  22. Boot Profiler Tests
+     - Recorded operations and keys
+     - Nesting past the depth limit
+
   Test Environment:
   - ESP32 development board
   - Serial connection for test results (default baud)
@@ -69,7 +175,12 @@
 */
 
 #include <CalibrationLib.h>
+#include <CalibrationWorkflow.h>
+#include <CalibrationChannel.h>
 #include <unity.h>
+#include <StreamString.h>
+#include <atomic>
+#include <thread>
 
 CalibrationLib calibration;
 
@@ -120,6 +231,13 @@ void test_json_operations(void) {
     calibration.setCalibrationValue("test_int", 42);
     calibration.setCalibrationValue("test_float", 3.14f);
     calibration.setCalibrationValue("test_string", "Hello");
+    calibration.storeTransform("test_model", CalibrationTransform::linear(2.0f, 1.0f));
+    // A full table exports as ~780 base64 characters on its own
+    CalibrationTable table(CalibrationTable::MAX_CHANNELS);
+    for (uint16_t c = 0; c < table.channelCount(); c++) {
+        table.setChannel(c, c * 0.5f, 1.0f + c * 0.01f);
+    }
+    calibration.storeCalibrationTable("test_table", table);
     
     String jsonData;
     TEST_ASSERT_TRUE(calibration.exportToJson(jsonData));
@@ -137,6 +255,825 @@ void test_json_operations(void) {
     TEST_ASSERT_EQUAL(42, intVal);
     TEST_ASSERT_FLOAT_WITHIN(0.001, 3.14f, floatVal);
     TEST_ASSERT_EQUAL_STRING("Hello", strVal.c_str());
+    
+    // Blobs round-trip through the base64 "blob" entry
+    CalibrationTransform model;
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.loadTransform("test_model", model));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 21.0f, model.apply(10.0f));
+    CalibrationTable loaded;
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.loadCalibrationTable("test_table", loaded));
+    TEST_ASSERT_EQUAL(CalibrationTable::MAX_CHANNELS, loaded.channelCount());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 31.5f, loaded.offset(63));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 1.63f, loaded.scale(63));
+    
+    // Input past CALIBRATION_MAX_IMPORT_SIZE is refused before parsing
+    String oversized = "{\"pad\":\"";
+    while (oversized.length() <= CALIBRATION_MAX_IMPORT_SIZE) oversized += "0123456789abcdef";
+    oversized += "\"}";
+    TEST_ASSERT_FALSE(calibration.importFromJson(oversized));
+    TEST_ASSERT_EQUAL(CAL_MEMORY_ERROR, calibration.getLastError());
+}
+
+void test_result_api(void) {
+    CalibrationError previousError = calibration.getLastError();
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.trySetCalibrationValue("res_float", 2.5f));
+    
+    CalibrationResult<float> found = calibration.tryGetCalibrationFloat("res_float");
+    TEST_ASSERT_TRUE(found.ok());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 2.5f, found.value);
+    
+    CalibrationResult<int> missing = calibration.tryGetCalibrationInt("res_missing");
+    TEST_ASSERT_EQUAL(CAL_NOT_FOUND, missing.error);
+    TEST_ASSERT_EQUAL(7, missing.valueOr(7));
+    
+    TEST_ASSERT_EQUAL(CAL_INVALID_PARAM, calibration.trySetCalibrationValue(nullptr, 1));
+    // Result variants leave the shared error state alone
+    TEST_ASSERT_EQUAL(previousError, calibration.getLastError());
+}
+
+void test_transforms(void) {
+    CalibrationTransform linear = CalibrationTransform::linear(0.5f, -10.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 40.0f, linear.apply(100.0f));
+    
+    const float coefficients[] = {1.0f, 2.0f, 3.0f};
+    CalibrationTransform poly = CalibrationTransform::polynomial(coefficients, 2);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 17.0f, poly.apply(2.0f));
+    
+    const float raw[] = {0.0f, 100.0f, 300.0f};
+    const float values[] = {0.0f, 10.0f, 50.0f};
+    CalibrationTransform table = CalibrationTransform::piecewise(raw, values, 3);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 5.0f, table.apply(50.0f));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 30.0f, table.apply(200.0f));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 60.0f, table.apply(350.0f));  // extrapolated
+    
+    // Batch path must match per-sample apply, including the unaligned tail
+    int16_t samples[19];
+    float batch[19];
+    for (int i = 0; i < 19; i++) samples[i] = i * 20 - 30;
+    linear.applyBatch(samples, batch, 19);
+    for (int i = 0; i < 19; i++) TEST_ASSERT_FLOAT_WITHIN(0.001, linear.apply(samples[i]), batch[i]);
+    poly.applyBatch(samples, batch, 19);
+    for (int i = 0; i < 19; i++) TEST_ASSERT_FLOAT_WITHIN(0.001, poly.apply(samples[i]), batch[i]);
+    
+    // Integer kernels stay within one output LSB of the float path
+    FixedPointTransform q15;
+    TEST_ASSERT_TRUE(q15.compile(linear, FIXED_Q15, 10.0f));
+    TEST_ASSERT_EQUAL(400, q15.apply(100));
+    TEST_ASSERT_EQUAL(INT16_MAX, q15.apply(30000));   // saturates
+    TEST_ASSERT_TRUE(q15.maxError(-1000, 1000) <= 0.5f);
+    FixedPointTransform q31;
+    TEST_ASSERT_TRUE(q31.compile(linear, FIXED_Q31, 10.0f));
+    TEST_ASSERT_EQUAL(149900, q31.apply(30000));
+    TEST_ASSERT_FALSE(q31.compile(poly, FIXED_Q31));
+    
+    // Lookup table follows coefficient changes on its transform
+    CalibrationTransform lutSource = CalibrationTransform::polynomial(coefficients, 2);
+    CalibrationLUT lut;
+    TEST_ASSERT_TRUE(lut.build(lutSource, 8));
+    TEST_ASSERT_EQUAL(256, lut.size());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 17.0f, lut.apply(2));
+    lutSource.setLinear(2.0f, 1.0f);
+    TEST_ASSERT_TRUE(lut.isStale());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 5.0f, lut.apply(2));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 511.0f, lut.apply(1000));  // clamped to last entry
+    // ...and reassignment from a factory, whose revision is its own
+    lutSource = CalibrationTransform::linear(5.0f, 100.0f);
+    TEST_ASSERT_TRUE(lut.isStale());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 150.0f, lut.apply(10));
+    
+    // Least-squares fit recovers a quadratic from running sums
+    CalibrationFitter fitter(2);
+    for (int i = 0; i < 50; i++) {
+        float x = i * 0.2f;
+        fitter.addPoint(x, 1.0f + 2.0f * x + 3.0f * x * x);
+    }
+    CalibrationTransform fitted;
+    FitResult fit;
+    TEST_ASSERT_TRUE(fitter.fit(fitted, &fit));
+    TEST_ASSERT_EQUAL(50, fit.count);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 17.0f, fitted.apply(2.0f));
+    TEST_ASSERT_TRUE(fit.rmse < 0.01);
+    
+    // A narrow raw range far from zero keeps its precision once stored
+    CalibrationTransform narrowLoaded;
+    for (uint8_t degree = 3; degree <= 5; degree += 2) {
+        CalibrationFitter narrow(degree, 3000.0f, 3100.0f);
+        for (int i = 0; i <= 100; i++) {
+            float t = i * 0.01f;
+            narrow.addPoint(3000.0f + i, 25.0f + 40.0f * t + 6.0f * t * t - 6.0f * t * t * t);
+        }
+        CalibrationTransform curve;
+        TEST_ASSERT_TRUE(narrow.fit(curve, &fit));
+        TEST_ASSERT_TRUE(fit.rmse < 0.001);
+        int16_t counts[101];
+        float curveBatch[101];
+        for (int i = 0; i <= 100; i++) counts[i] = 3000 + i;
+        curve.applyBatch(counts, curveBatch, 101);
+        for (int i = 0; i <= 100; i++) {
+            float t = i * 0.01f;
+            float expected = 25.0f + 40.0f * t + 6.0f * t * t - 6.0f * t * t * t;
+            TEST_ASSERT_FLOAT_WITHIN(0.001, expected, curve.apply(counts[i]));
+            TEST_ASSERT_FLOAT_WITHIN(0.001, expected, curveBatch[i]);
+        }
+        TEST_ASSERT_EQUAL(CAL_OK, calibration.storeTransform("tf_narrow", curve));
+        TEST_ASSERT_EQUAL(CAL_OK, calibration.loadTransform("tf_narrow", narrowLoaded));
+        TEST_ASSERT_FLOAT_WITHIN(0.0001, curve.apply(3050.0f), narrowLoaded.apply(3050.0f));
+        PolynomialModel<5> model;
+        TEST_ASSERT_TRUE(model.load(curve));
+        TEST_ASSERT_FLOAT_WITHIN(0.0001, curve.apply(3050.0f), model.apply(3050.0f));
+        
+        // Raw-power coefficients report the precision they lose
+        float rawPowers[CalibrationFitter::MAX_DEGREE + 1];
+        FitResult expanded;
+        TEST_ASSERT_TRUE(narrow.solve(rawPowers, &expanded));
+        TEST_ASSERT_TRUE(expanded.rmse > fit.rmse);
+    }
+    
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.storeTransform("tf_table", table));
+    CalibrationTransform loaded;
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.loadTransform("tf_table", loaded));
+    TEST_ASSERT_EQUAL(TRANSFORM_PIECEWISE, loaded.type());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 30.0f, loaded.apply(200.0f));
+    TEST_ASSERT_EQUAL(CAL_NOT_FOUND, calibration.loadTransform("tf_missing", loaded));
+}
+
+void test_calibrated_channel(void) {
+    const float coefficients[] = {1.0f, 0.5f, 0.01f};
+    CalibrationTransform poly = CalibrationTransform::polynomial(coefficients, 2);
+    const float raw[] = {0.0f, 100.0f, 300.0f};
+    const float values[] = {0.0f, 50.0f, 80.0f};
+    CalibrationTransform table = CalibrationTransform::piecewise(raw, values, 3);
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.storeTransform("ch_poly", poly));
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.storeTransform("ch_table", table));
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.storeTransform("ch_lin", CalibrationTransform::linear(2.0f, -3.6f)));
+    
+    // A larger model holds a smaller stored one; the table is padded
+    CalibratedChannel<PolynomialModel<3> > cubic("ch_poly");
+    CalibratedChannel<PiecewiseModel<8> > piecewise("ch_table");
+    CalibratedChannel<LinearModel, int16_t, int16_t> counts("ch_lin");
+    TEST_ASSERT_EQUAL(CAL_OK, loadChannels(calibration, cubic, piecewise, counts));
+    const int16_t inputs[] = {-50, 0, 7, 150, 299, 400};
+    for (int i = 0; i < 6; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(0.001, poly.apply(inputs[i]), cubic.apply(inputs[i]));
+        TEST_ASSERT_FLOAT_WITHIN(0.001, table.apply(inputs[i]), piecewise.apply(inputs[i]));
+    }
+    
+    // Integer outputs round to nearest and saturate
+    TEST_ASSERT_EQUAL(10, counts.apply(7));
+    TEST_ASSERT_EQUAL(-12, counts.apply(-4));
+    TEST_ASSERT_EQUAL(32767, counts.apply(30000));
+    int16_t out[6];
+    counts.applyBatch(inputs, out, 6);
+    TEST_ASSERT_EQUAL(296, out[3]);
+    TEST_ASSERT_EQUAL(-32768, ChannelOutput<int16_t>::convert(-1e9f));
+    TEST_ASSERT_EQUAL(0, ChannelOutput<uint8_t>::convert(-3.0f));
+    TEST_ASSERT_EQUAL(-3, ChannelOutput<int32_t>::convert(-2.5f));
+    TEST_ASSERT_EQUAL(0, ChannelOutput<int16_t>::convert(NAN));
+    // Floating outputs keep sign and NaN
+    TEST_ASSERT_TRUE(ChannelOutput<double>::convert(-5.5f) == -5.5);
+    TEST_ASSERT_TRUE(isnan(ChannelOutput<double>::convert(NAN)));
+    
+    // A model that cannot represent the stored transform is left untouched
+    CalibratedChannel<LinearModel> mismatch("ch_poly");
+    TEST_ASSERT_EQUAL(CAL_READ_ERROR, mismatch.load(calibration));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 1.0f, mismatch.model().scale);
+    CalibratedChannel<LinearModel> missing("ch_none");
+    TEST_ASSERT_EQUAL(CAL_NOT_FOUND, missing.load(calibration));
+    TEST_ASSERT_EQUAL(CAL_OK, counts.store(calibration));
+}
+
+void test_calibration_table(void) {
+    // 11 channels: two unrolled groups of four plus a scalar tail
+    const uint16_t channels = 11;
+    CalibrationTable table(channels);
+    for (uint16_t c = 0; c < channels; c++) {
+        TEST_ASSERT_TRUE(table.setChannel(c, 10.0f * c, 0.5f + c));
+    }
+    TEST_ASSERT_FALSE(table.setChannel(channels, 0.0f, 1.0f));
+    table.setEnabled(3, false);
+    
+    int16_t frames[2 * channels];
+    float out[2 * channels];
+    for (uint16_t i = 0; i < 2 * channels; i++) {
+        frames[i] = 100 + i;
+    }
+    table.applyFrames(frames, out, 2);
+    for (uint16_t f = 0; f < 2; f++) {
+        for (uint16_t c = 0; c < channels; c++) {
+            float expected = c == 3 ? 0.0f : (frames[f * channels + c] - 10.0f * c) * (0.5f + c);
+            TEST_ASSERT_FLOAT_WITHIN(0.001, expected, out[f * channels + c]);
+        }
+    }
+    
+    // The blob restores coefficients and flags; units stay in code
+    table.setUnit(0, "mV");
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.storeCalibrationTable("table", table));
+    CalibrationTable loaded;
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.loadCalibrationTable("table", loaded));
+    TEST_ASSERT_EQUAL(channels, loaded.channelCount());
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 70.0f, loaded.offset(7));
+    TEST_ASSERT_EQUAL(TABLE_CHANNEL_CALIBRATED, loaded.flags(3));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, out[channels + 5], loaded.apply(5, frames[channels + 5]));
+    TEST_ASSERT_EQUAL_STRING("", loaded.unit(0));
+    TEST_ASSERT_FALSE(loaded.setChannelCount(CalibrationTable::MAX_CHANNELS + 1));
+}
+
+void test_sample_accumulator(void) {
+    SampleAccumulator samples(6);
+    for (int i = 1; i <= 4; i++) samples.add(i);
+    TEST_ASSERT_FALSE(samples.isReady());
+    samples.addFromISR(5);
+    samples.addFromISR(6);
+    TEST_ASSERT_TRUE(samples.isReady());
+    TEST_ASSERT_EQUAL(6, samples.count());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 3.5f, samples.mean());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 3.5f, samples.variance());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 1.0f, samples.minValue());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 6.0f, samples.maxValue());
+    
+    // A settled input signals before the count target
+    SampleAccumulator settled(1000);
+    settled.setStabilityThreshold(0.01f, 5);
+    for (int i = 0; i < 5; i++) settled.add(20.0f + 0.05f * (i % 2));
+    TEST_ASSERT_TRUE(settled.isReady());
+    
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.storeOffset("acc_offset", samples, 10.0f));
+    CalibrationResult<float> offset = calibration.tryGetCalibrationFloat("acc_offset");
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 6.5f, offset.value);
+    SampleAccumulator empty;
+    TEST_ASSERT_EQUAL(CAL_INVALID_PARAM, calibration.storeOffset("acc_offset", empty));
+    
+    // One empty accumulator rejects the whole group before any write
+    SampleAccumulator group[2];
+    group[0].add(3.0f);
+    const char* keys[] = {"acc_first", "acc_second"};
+    TEST_ASSERT_EQUAL(CAL_INVALID_PARAM, calibration.storeOffsets(keys, group, nullptr, 2));
+    TEST_ASSERT_EQUAL(CAL_NOT_FOUND, calibration.tryGetCalibrationFloat("acc_first").error);
+    group[1].add(-1.0f);
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.storeOffsets(keys, group, nullptr, 2));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 1.0f, calibration.tryGetCalibrationFloat("acc_second").value);
+}
+
+void test_robust_aggregation(void) {
+    // One ADC spike among otherwise steady readings
+    RobustAggregator<11> samples;
+    for (int i = 0; i < 10; i++) samples.add(100.0f + (i % 3));
+    samples.add(4095.0f);
+    TEST_ASSERT_FALSE(samples.add(0.0f));   // full
+    TEST_ASSERT_TRUE(samples.mean() > 400.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 101.0f, samples.median());
+    samples.setTrimFraction(0.1f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 101.0f, samples.trimmedMean());
+    size_t kept;
+    float robust = samples.madMean(&kept);
+    TEST_ASSERT_EQUAL(10, kept);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 100.9f, robust);
+    
+    float values[5] = {5, 1, 4, 2, 3};
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 2.0f, selectNth(values, 5, 1));
+    
+    StreamingQuantile median;
+    for (int i = 0; i < 1000; i++) median.add((i * 37) % 101);   // 0..100 scrambled
+    TEST_ASSERT_FLOAT_WITHIN(3.0, 50.0f, median.value());
+    
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.storeOffset("robust_offset", samples, 100.0f));
+    CalibrationResult<float> offset = calibration.tryGetCalibrationFloat("robust_offset");
+    TEST_ASSERT_FLOAT_WITHIN(0.001, -1.0f, offset.value);
+}
+
+void test_axis_calibration(void) {
+    // Simulated accelerometer: 2% gain error on X and a 0.5 m/s^2 Z bias
+    const float g = 9.80665f;
+    const float faces[6][3] = {
+        {1.02f * g, 0, 0.5f}, {-1.02f * g, 0, 0.5f},
+        {0, g, 0.5f}, {0, -g, 0.5f},
+        {0, 0, g + 0.5f}, {0, 0, -g + 0.5f},
+    };
+    AxisCalibrationFitter fitter;
+    for (int i = 0; i < 6; i++) fitter.addGravitySample(faces[i], g);
+    TEST_ASSERT_EQUAL(0x3F, fitter.facesSeen());
+    
+    AxisCalibration model;
+    TEST_ASSERT_TRUE(fitter.fit(model));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.5f, model.bias()[2]);
+    float corrected[3];
+    model.apply(faces[0], corrected);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, g, corrected[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.0f, corrected[2]);
+    
+    float batch[18];
+    model.applyBatch(&faces[0][0], batch, 6);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, -g, batch[17]);  // last frame, Z axis
+    
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.storeAxisCalibration("accel_model", model));
+    AxisCalibration loaded;
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.loadAxisCalibration("accel_model", loaded));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, model.matrix()[0], loaded.matrix()[0]);
+    
+    // Magnetometer on a stretched, offset ellipsoid maps back to a sphere
+    EllipsoidFitter ellipsoid;
+    const float stretch[3] = {1.3f, 0.8f, 1.0f};
+    const float hardIron[3] = {20.0f, -35.0f, 8.0f};
+    for (int lon = 0; lon < 360; lon += 30) {
+        for (int lat = -80; lat <= 80; lat += 20) {
+            float u[3] = {cosf(lat * DEG_TO_RAD) * cosf(lon * DEG_TO_RAD),
+                          cosf(lat * DEG_TO_RAD) * sinf(lon * DEG_TO_RAD),
+                          sinf(lat * DEG_TO_RAD)};
+            float raw[3];
+            for (int i = 0; i < 3; i++) raw[i] = 50.0f * stretch[i] * u[i] + hardIron[i];
+            ellipsoid.addSample(raw);
+        }
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 1.0f, ellipsoid.coverage());
+    AxisCalibration magnetic;
+    TEST_ASSERT_TRUE(ellipsoid.fit(magnetic, 50.0f));
+    TEST_ASSERT_FLOAT_WITHIN(0.01, -35.0f, magnetic.bias()[1]);
+    float reading[3] = {65.0f + 20.0f, -35.0f, 8.0f};   // +X pole
+    magnetic.apply(reading, reading);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 50.0f, reading[0]);
+}
+
+void test_thermal_calibration(void) {
+    const float temps[] = {0.0f, 20.0f, 40.0f};
+    const float offsets[] = {2.0f, 0.0f, -4.0f};
+    const float scales[] = {1.0f, 1.0f, 1.1f};
+    ThermalCalibration thermal;
+    TEST_ASSERT_TRUE(thermal.setTable(temps, offsets, scales, 3));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 101.0f, thermal.apply(100.0f, 10.0f));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 103.0f, thermal.apply(100.0f, 30.0f));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 106.0f, thermal.apply(100.0f, 85.0f));   // held at 40
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 102.0f, thermal.apply(100.0f, -20.0f));  // held at 0
+    
+    float batch[2] = {10.0f, 20.0f};
+    thermal.applyBatch(batch, batch, 2, 30.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 8.5f, batch[0]);
+    
+    const float unordered[] = {20.0f, 10.0f};
+    TEST_ASSERT_FALSE(thermal.setTable(unordered, offsets, nullptr, 2));
+    
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.storeThermalCalibration("pres_thermal", thermal));
+    ThermalCalibration loaded;
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.loadThermalCalibration("pres_thermal", loaded));
+    TEST_ASSERT_EQUAL(3, loaded.size());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 103.0f, loaded.apply(100.0f, 30.0f));
+}
+
+void test_color_calibration(void) {
+    ColorCalibration led;
+    led.setGain(1.0f, 0.5f, 1.0f);
+    led.setGamma(2.0f);
+    ColorLUT lut;
+    TEST_ASSERT_TRUE(lut.build(led, 12));
+    TEST_ASSERT_FALSE(lut.mixesChannels());
+    uint16_t duty[3];
+    lut.apply(255, 255, 0, duty);
+    TEST_ASSERT_EQUAL(4095, duty[0]);
+    TEST_ASSERT_EQUAL(2048, duty[1]);   // half gain
+    TEST_ASSERT_EQUAL(0, duty[2]);
+    TEST_ASSERT_EQUAL(1032, lut.channel(0, 128));   // (128/255)^2 * 4095
+    
+    // Red leaks a quarter into green in linear light
+    const float balance[9] = {1, 0, 0, 0.25f, 1, 0, 0, 0, 1};
+    led.setMatrix(balance);
+    TEST_ASSERT_TRUE(lut.build(led, 12));
+    TEST_ASSERT_TRUE(lut.mixesChannels());
+    const uint8_t frame[6] = {255, 0, 0, 0, 0, 255};
+    uint16_t frameDuty[6];
+    lut.applyBatch(frame, frameDuty, 2);
+    TEST_ASSERT_INT_WITHIN(1, 4095, frameDuty[0]);
+    TEST_ASSERT_INT_WITHIN(1, 512, frameDuty[1]);   // 0.5 * 0.25 * 4095
+    TEST_ASSERT_INT_WITHIN(1, 4095, frameDuty[5]);
+    
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.storeColorCalibration("led_color", led));
+    ColorCalibration loaded;
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.loadColorCalibration("led_color", loaded));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 0.5f, loaded.gain()[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 0.25f, loaded.matrix()[3]);
+}
+
+void test_pipeline(void) {
+    SyntheticSource source(2);
+    source.setSignal(0, 1000.0f);
+    source.setSignal(1, 2000.0f);
+    CalibrationTransform half = CalibrationTransform::linear(0.5f, 10.0f);
+    CalibrationPipeline pipeline(source);
+    TEST_ASSERT_TRUE(pipeline.attachChannel(0, half));
+    
+    // Two raw blocks fill one block per channel; channel 1 is not attached
+    pipeline.process();
+    pipeline.process();
+    TEST_ASSERT_EQUAL(1, pipeline.available());
+    TEST_ASSERT_EQUAL(CalibrationPipeline::BLOCK_SIZE, pipeline.unmappedSamples());
+    const CalibratedBlock* block = pipeline.peek();
+    TEST_ASSERT_NOT_NULL(block);
+    TEST_ASSERT_EQUAL(0, block->channel);
+    TEST_ASSERT_EQUAL(CalibrationPipeline::BLOCK_SIZE, block->count);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 510.0f, block->values[block->count - 1]);
+    pipeline.release();
+    TEST_ASSERT_NULL(pipeline.peek());
+    
+    // A consumer that never drains loses blocks, and the count says so
+    for (int i = 0; i < 4 * CalibrationPipeline::DEPTH; i++) pipeline.process();
+    TEST_ASSERT_EQUAL(CalibrationPipeline::DEPTH, pipeline.available());
+    TEST_ASSERT_TRUE(pipeline.droppedBlocks() > 0);
+    CalibratedBlock copy;
+    TEST_ASSERT_TRUE(pipeline.read(copy));
+    TEST_ASSERT_EQUAL(CalibrationPipeline::BLOCK_SIZE, copy.firstSample);
+}
+
+void test_drift_monitor(void) {
+    DriftMonitor gyro(0.02f);
+    DriftMonitor temp(1.0f);
+    RecalibrationScheduler scheduler;
+    TEST_ASSERT_EQUAL(0, scheduler.addChannel("gyro", gyro, 2));
+    TEST_ASSERT_EQUAL(1, scheduler.addChannel("temp", temp, 1, 3600));
+    TEST_ASSERT_EQUAL(-1, scheduler.next());
+    
+    // Too few checks are not trusted, however large the residual
+    gyro.addCheck(0.05f, 0.0f);
+    gyro.addCheck(0.05f, 0.0f);
+    TEST_ASSERT_FALSE(gyro.needsRecalibration());
+    gyro.addCheck(0.05f, 0.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 0.05f, gyro.bias());
+    TEST_ASSERT_TRUE(gyro.needsRecalibration());
+    for (int i = 0; i < 5; i++) temp.addAgreement(20.2f, 20.0f);
+    TEST_ASSERT_FALSE(temp.needsRecalibration());
+    
+    // Two hours of operation put temp past its age limit, but the gyro's
+    // drift score times its weight still ranks first
+    scheduler.update(0);
+    scheduler.update(7200000UL);
+    TEST_ASSERT_EQUAL(7200, temp.operatingSeconds());
+    TEST_ASSERT_EQUAL(2, scheduler.dueCount());
+    TEST_ASSERT_EQUAL(0, scheduler.next());
+    scheduler.markRecalibrated(0);
+    TEST_ASSERT_EQUAL(1, scheduler.next());
+    
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.storeDriftMonitor("drift", temp));
+    DriftMonitor restored(1.0f);
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.loadDriftMonitor("drift", restored));
+    TEST_ASSERT_EQUAL(5, restored.checks());
+    TEST_ASSERT_EQUAL(7200, restored.operatingSeconds());
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 0.2f, restored.bias());
+}
+
+void test_kalman_filter(void) {
+    // Constant tilt seen by a gyro with a 0.05 rad/s bias: the filter
+    // attributes the gyro's apparent rotation to bias
+    KalmanFilter<2, 1> tilt;
+    const float dt = 0.01f;
+    const float F[] = {1.0f, -dt, 0.0f, 1.0f};
+    const float H[] = {1.0f, 0.0f};
+    const float Q[] = {1e-5f, 0.0f, 0.0f, 1e-6f};
+    tilt.setTransition(F);
+    tilt.setObservation(H);
+    tilt.setProcessNoise(Q);
+    tilt.setMeasurementNoise(1e-3f);
+    float angle = 0.3f;
+    for (int i = 0; i < 2000; i++) {
+        float u[] = {0.05f * dt, 0.0f};
+        tilt.predict(u);
+        TEST_ASSERT_TRUE(tilt.update(&angle));
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.005, 0.3f, tilt.state(0));
+    TEST_ASSERT_FLOAT_WITHIN(0.005, 0.05f, tilt.state(1));
+    
+    // Two sensors with variances 1 and 3 fuse to the weighted mean 1.25;
+    // a vague prior shifts it only slightly
+    KalmanFilter<1, 2> fused;
+    const float fusedH[] = {1.0f, 1.0f};
+    const float fusedR[] = {1.0f, 0.0f, 0.0f, 3.0f};
+    fused.setObservation(fusedH);
+    fused.setMeasurementNoise(fusedR);
+    fused.setState(nullptr, 1e3f);
+    const float z[] = {1.0f, 2.0f};
+    TEST_ASSERT_TRUE(fused.update(z));
+    TEST_ASSERT_FLOAT_WITHIN(0.002, 1.25f, fused.state(0));
+    TEST_ASSERT_FLOAT_WITHIN(0.002, 0.75f, fused.variance(0));
+    
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.storeKalmanTuning("kf_tune", tilt));
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.storeKalmanState("kf_state", tilt));
+    KalmanFilter<2, 1> restored;
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.loadKalmanTuning("kf_tune", restored));
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.loadKalmanState("kf_state", restored));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, tilt.state(1), restored.state(1));
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, tilt.variance(0), restored.variance(0));
+    // Blobs carry their dimensions and kind
+    TEST_ASSERT_EQUAL(CAL_READ_ERROR, calibration.loadKalmanState("kf_state", fused));
+    TEST_ASSERT_EQUAL(CAL_READ_ERROR, calibration.loadKalmanState("kf_tune", restored));
+}
+
+float workflowInput = 0.0f;
+float readWorkflowInput(void* context) {
+    return workflowInput;
+}
+
+void test_workflow(void) {
+    const WorkflowStep steps[] = {
+        {"low", 0.0f, 100, 5},
+        {"high", 100.0f, 100, 5},
+    };
+    CalibrationWorkflow workflow(calibration, "wf_model", readWorkflowInput);
+    workflow.setOutput(nullptr);
+    TEST_ASSERT_FALSE(workflow.start(steps, 1));   // a line needs two points
+    TEST_ASSERT_TRUE(workflow.start(steps, 2));
+    
+    // Nothing happens until the prompt is confirmed
+    uint32_t now = 0;
+    TEST_ASSERT_EQUAL(WORKFLOW_PROMPT, workflow.tick(now += 1000));
+    workflow.confirm();
+    TEST_ASSERT_EQUAL(WORKFLOW_SETTLE, workflow.tick(now));
+    TEST_ASSERT_EQUAL(WORKFLOW_SETTLE, workflow.tick(now += 50));
+    
+    workflowInput = 200.0f;
+    while (workflow.currentStep() == 0) {
+        workflow.tick(now += 10);
+    }
+    workflowInput = 600.0f;
+    workflow.confirm();
+    while (workflow.isActive() && now < 10000) {
+        workflow.tick(now += 10);
+    }
+    TEST_ASSERT_EQUAL(WORKFLOW_DONE, workflow.state());
+    
+    CalibrationTransform stored;
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.loadTransform("wf_model", stored));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 50.0f, stored.apply(400.0f));
+}
+
+void test_encrypted_bundle(void) {
+    TEST_ASSERT_TRUE(calibration.enableEncryption("MySecretKey12345"));
+    calibration.setCalibrationValue("bundle_int", 7);
+    CalibrationTable table(CalibrationTable::MAX_CHANNELS);
+    table.setChannel(40, 12.0f, 0.5f);
+    calibration.storeCalibrationTable("bundle_table", table);
+    
+    StreamString bundle;
+    TEST_ASSERT_TRUE(calibration.exportEncryptedBundle(bundle));
+    
+    // A tampered bundle must be rejected
+    StreamString tampered;
+    tampered = bundle;
+    tampered.setCharAt(tampered.length() - 1, tampered[tampered.length() - 1] ^ 0x01);
+    TEST_ASSERT_FALSE(calibration.importEncryptedBundle(tampered));
+    TEST_ASSERT_EQUAL(CAL_ENCRYPTION_ERROR, calibration.getLastError());
+    
+    calibration.clearAllCalibrationValues();
+    TEST_ASSERT_TRUE(calibration.importEncryptedBundle(bundle));
+    
+    int intVal;
+    calibration.getCalibrationValue("bundle_int", intVal);
+    TEST_ASSERT_EQUAL(7, intVal);
+    CalibrationTable loaded;
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.loadCalibrationTable("bundle_table", loaded));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 12.0f, loaded.offset(40));
+    TEST_ASSERT_TRUE(calibration.disableEncryption());
+}
+
+// Counts drained log lines and checks each one is a complete record
+struct LogLineCounter : public Print {
+    char line[64];
+    size_t used = 0;
+    uint32_t lines = 0;
+    uint32_t malformed = 0;
+    
+    size_t write(uint8_t c) override {
+        if (c == '\r') return 1;
+        if (c != '\n') {
+            if (used < sizeof(line) - 1) line[used++] = c;
+            return 1;
+        }
+        line[used] = '\0';
+        used = 0;
+        const char* text = strchr(line, ']');
+        int p, i, check;
+        if (!text || sscanf(text + 2, "p%d i%d c%d", &p, &i, &check) != 3 || check != p * 7919 + i) {
+            malformed++;
+        }
+        lines++;
+        return 1;
+    }
+};
+
+void test_deferred_log(void) {
+    // Arguments keep their types until drain() formats them
+    CalibrationLogBuffer ring;
+    TEST_ASSERT_TRUE(ring.allocate(3));   // rounded up to 4 entries
+    char key[16] = "sensor_offset_x";
+    ring.record(DEBUG_INFO, "%d %u %.2f %s", -3, 7u, 1.5, LogText{key});
+    strcpy(key, "overwritten");
+    for (int i = 0; i < 5; i++) ring.record(DEBUG_INFO, "entry %d", i);
+    TEST_ASSERT_EQUAL(4, ring.pending());
+    TEST_ASSERT_EQUAL(2, ring.dropped());
+    
+    StreamString out;
+    TEST_ASSERT_EQUAL(4, ring.drain(out));
+    TEST_ASSERT_TRUE(out.indexOf("] -3 7 1.50 sensor_offset_x\n") > 0);
+    TEST_ASSERT_TRUE(out.indexOf("entry 2\n") > 0);
+    TEST_ASSERT_EQUAL(-1, out.indexOf("entry 3"));
+    TEST_ASSERT_EQUAL(0, ring.pending());
+    
+    // Concurrent producers: every record is printed whole or counted
+    CalibrationLogBuffer shared;
+    TEST_ASSERT_TRUE(shared.allocate(64));
+    LogLineCounter lines;
+    std::atomic<bool> producing(true);
+    std::thread consumer([&]() {
+        while (producing.load()) shared.drain(lines);
+        shared.drain(lines);
+    });
+    std::thread producers[2];
+    for (int p = 0; p < 2; p++) {
+        producers[p] = std::thread([&shared, p]() {
+            for (int i = 0; i < 2000; i++) shared.record(DEBUG_INFO, "p%d i%d c%d", p, i, p * 7919 + i);
+        });
+    }
+    for (auto& producer : producers) producer.join();
+    producing.store(false);
+    consumer.join();
+    TEST_ASSERT_EQUAL(0, lines.malformed);
+    TEST_ASSERT_EQUAL(4000, lines.lines + shared.dropped());
+    
+    // Library messages are not cut to the LogText copy size
+    StreamString log;
+    calibration.setDebugOutput(&log);
+    calibration.setDebugLevel(DEBUG_ERROR);
+    TEST_ASSERT_TRUE(calibration.setLogMode(LOG_DEFERRED, 8));
+    calibration.trySetCalibrationValue(nullptr, 1);
+    TEST_ASSERT_EQUAL(0, log.length());
+    TEST_ASSERT_EQUAL(1, calibration.flushLog());
+    TEST_ASSERT_TRUE(log.indexOf("Error: Invalid parameter") > 0);
+    TEST_ASSERT_TRUE(calibration.setLogMode(LOG_IMMEDIATE));
+    calibration.setDebugLevel(DEBUG_NONE);
+    calibration.setDebugOutput(&Serial);
+}
+
+void test_latency_histogram(void) {
+    // Bucket 0 is 0us, bucket i holds [2^(i-1), 2^i)
+    LatencyHistogram histogram;
+    histogram.record(0);
+    histogram.record(1);
+    histogram.record(7);
+    histogram.record(8);
+    histogram.record(1000);
+    histogram.record(UINT32_MAX);
+    TEST_ASSERT_EQUAL(1, histogram.buckets[0]);
+    TEST_ASSERT_EQUAL(1, histogram.buckets[1]);
+    TEST_ASSERT_EQUAL(1, histogram.buckets[3]);
+    TEST_ASSERT_EQUAL(1, histogram.buckets[4]);
+    TEST_ASSERT_EQUAL(1, histogram.buckets[10]);
+    TEST_ASSERT_EQUAL(1, histogram.buckets[LatencyHistogram::BUCKETS - 1]);
+    TEST_ASSERT_EQUAL(6, histogram.count);
+    TEST_ASSERT_EQUAL(0, histogram.minUs);
+    TEST_ASSERT_EQUAL(UINT32_MAX, histogram.maxUs);
+    
+    // Percentiles report the bucket's upper bound, capped at the maximum
+    histogram.reset();
+    for (int i = 0; i < 90; i++) histogram.record(5);
+    for (int i = 0; i < 10; i++) histogram.record(1000);
+    TEST_ASSERT_EQUAL(104, histogram.averageUs());
+    TEST_ASSERT_EQUAL(7, histogram.percentileUs(50));
+    TEST_ASSERT_EQUAL(7, histogram.percentileUs(90));
+    TEST_ASSERT_EQUAL(1000, histogram.percentileUs(91));
+    TEST_ASSERT_EQUAL(1000, histogram.percentileUs(99));
+    
+    LatencyHistogram empty;
+    TEST_ASSERT_EQUAL(0, empty.percentileUs(50));
+    
+    // Only filled in when the library is built with profiling enabled
+    LatencyHistogram fromLib;
+    TEST_ASSERT_EQUAL(CALIBRATION_ENABLE_PROFILING != 0,
+                      calibration.getLatencyHistogram(CAL_OP_SET, fromLib));
+}
+
+void test_metrics(void) {
+    calibration.resetMetrics();
+    TEST_ASSERT_EQUAL(CAL_OK, calibration.trySetCalibrationValue("met_int", 5));
+    TEST_ASSERT_TRUE(calibration.tryGetCalibrationInt("met_int").ok());
+    TEST_ASSERT_EQUAL(CAL_NOT_FOUND, calibration.tryGetCalibrationInt("met_missing").error);
+    TEST_ASSERT_EQUAL(CAL_INVALID_PARAM, calibration.tryGetCalibrationInt(nullptr).error);
+    
+    const CalibrationMetrics& metrics = calibration.getMetrics();
+    TEST_ASSERT_EQUAL(1, metrics.nvsWrites.load());
+    TEST_ASSERT_EQUAL(4, metrics.bytesWritten.load());
+    TEST_ASSERT_EQUAL(2, metrics.nvsReads.load());
+    // A missing key is a result, not an error
+    TEST_ASSERT_EQUAL(1, metrics.errorCount(CAL_INVALID_PARAM));
+    TEST_ASSERT_EQUAL(0, metrics.errorCount(CAL_NOT_FOUND));
+    
+    StreamString prometheus;
+    calibration.writeMetrics(prometheus, METRICS_PROMETHEUS);
+    TEST_ASSERT_TRUE(prometheus.startsWith("# TYPE calibration_nvs_reads_total counter\n"));
+    TEST_ASSERT_TRUE(prometheus.indexOf("\ncalibration_nvs_writes_total{namespace=\"test\"} 1\n") > 0);
+    TEST_ASSERT_TRUE(prometheus.indexOf("\ncalibration_bytes_written_total{namespace=\"test\"} 4\n") > 0);
+    TEST_ASSERT_TRUE(prometheus.indexOf("\ncalibration_errors_total{namespace=\"test\",code=\"invalid_param\"} 1\n") > 0);
+    TEST_ASSERT_TRUE(prometheus.endsWith("code=\"not_found\"} 0\n"));
+    
+    StreamString json;
+    calibration.writeMetrics(json, METRICS_JSON);
+    StaticJsonDocument<512> doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, json.c_str()));
+    TEST_ASSERT_EQUAL_STRING("test", doc["namespace"].as<const char*>());
+    TEST_ASSERT_EQUAL(2, doc["nvs_reads"].as<int>());
+    TEST_ASSERT_EQUAL(1, doc["nvs_writes"].as<int>());
+    TEST_ASSERT_EQUAL(1, doc["errors"]["invalid_param"].as<int>());
+    TEST_ASSERT_EQUAL(0, doc["errors"]["not_found"].as<int>());
+}
+
+// Trace hook that checks every end closes the innermost open operation
+struct TraceRecorder {
+    CalibrationOp open[16];
+    uint8_t depth = 0;
+    uint8_t maxDepth = 0;
+    uint32_t begins = 0;
+    uint32_t mismatched = 0;
+    bool sawKey = false;
+    
+    static void hook(void* context, TracePhase phase, CalibrationOp op, const char* detail) {
+        TraceRecorder* recorder = static_cast<TraceRecorder*>(context);
+        if (phase == TRACE_BEGIN) {
+            recorder->begins++;
+            if (detail && strcmp(detail, "trace_key") == 0) recorder->sawKey = true;
+            if (recorder->depth < 16) recorder->open[recorder->depth] = op;
+            recorder->depth++;
+            if (recorder->depth > recorder->maxDepth) recorder->maxDepth = recorder->depth;
+        } else if (recorder->depth == 0 || recorder->open[--recorder->depth] != op) {
+            recorder->mismatched++;
+        }
+    }
+};
+
+void test_trace_hooks(void) {
+    TraceRecorder recorder;
+    calibration.setTraceHook(TraceRecorder::hook, &recorder);
+    calibration.setCalibrationValue("trace_key", 1);
+    int value;
+    calibration.getCalibrationValue("trace_key", value);
+    String json;
+    calibration.exportToJson(json);   // export nests read and serialize phases
+    calibration.setTraceHook(nullptr);
+    calibration.getCalibrationValue("trace_key", value);
+    
+    TEST_ASSERT_TRUE(recorder.begins >= 4);
+    TEST_ASSERT_EQUAL(0, recorder.mismatched);
+    TEST_ASSERT_EQUAL(0, recorder.depth);
+    TEST_ASSERT_TRUE(recorder.maxDepth >= 2);
+    TEST_ASSERT_TRUE(recorder.sawKey);
+    
+    // Chrome trace output: one JSON array of paired B/E events
+    StreamString trace;
+    ChromeTraceWriter writer(trace);
+    calibration.setTraceHook(ChromeTraceWriter::hook, &writer);
+    calibration.setCalibrationValue("trace_key", 2);
+    calibration.setTraceHook(nullptr);
+    writer.finish();
+    TEST_ASSERT_TRUE(trace.startsWith("[\n{\"name\":\"set\",\"cat\":\"calibration\",\"ph\":\"B\""));
+    TEST_ASSERT_TRUE(trace.indexOf("\"args\":{\"key\":\"trace_key\"}}") > 0);
+    TEST_ASSERT_TRUE(trace.indexOf(",\n{\"name\":\"set\",\"cat\":\"calibration\",\"ph\":\"E\"") > 0);
+    TEST_ASSERT_TRUE(trace.endsWith("}]\n"));
+    
+    // Keys are escaped into valid JSON strings
+    StreamString quoted;
+    ChromeTraceWriter quotedWriter(quoted);
+    ChromeTraceWriter::hook(&quotedWriter, TRACE_BEGIN, CAL_OP_GET, "a\"b\\c\n");
+    TEST_ASSERT_TRUE(quoted.indexOf("\"args\":{\"key\":\"a\\\"b\\\\c\\u000a\"}}") > 0);
+}
+
+void test_boot_profiler(void) {
+    BootProfiler profiler;
+    calibration.setTraceHook(BootProfiler::hook, &profiler);
+    calibration.setCalibrationValue("boot_key", 3);
+    calibration.setTraceHook(nullptr);
+    TEST_ASSERT_EQUAL(1, profiler.recordCount());
+    TEST_ASSERT_EQUAL_STRING("boot_key", profiler.record(0).detail);
+    TEST_ASSERT_EQUAL(CAL_OP_SET, profiler.record(0).op);
+    
+    // Scopes nested past MAX_DEPTH are dropped without unbalancing the
+    // stack: the outer scopes stay open until their own ends
+    profiler.reset();
+    const uint8_t nested = BootProfiler::MAX_DEPTH + 2;
+    for (uint8_t i = 0; i < nested; i++) {
+        BootProfiler::hook(&profiler, TRACE_BEGIN, CAL_OP_GET, "nested");
+    }
+    TEST_ASSERT_EQUAL(BootProfiler::MAX_DEPTH, profiler.recordCount());
+    TEST_ASSERT_EQUAL(2, profiler.droppedRecords());
+    for (uint8_t i = 0; i < nested - 1; i++) {
+        BootProfiler::hook(&profiler, TRACE_END, CAL_OP_GET, "nested");
+    }
+    // Only the outermost scope is still open, so a new one nests under it
+    BootProfiler::hook(&profiler, TRACE_BEGIN, CAL_OP_SET, "sibling");
+    BootProfiler::hook(&profiler, TRACE_END, CAL_OP_SET, "sibling");
+    BootProfiler::hook(&profiler, TRACE_END, CAL_OP_GET, "nested");
+    TEST_ASSERT_EQUAL(BootProfiler::MAX_DEPTH + 1, profiler.recordCount());
+    TEST_ASSERT_EQUAL(1, profiler.record(BootProfiler::MAX_DEPTH).depth);
+    TEST_ASSERT_TRUE(profiler.record(0).totalUs >= profiler.record(1).totalUs);
+    
+    // Nothing has elapsed until the first scope ends
+    profiler.reset();
+    BootProfiler::hook(&profiler, TRACE_BEGIN, CAL_OP_GET, "open");
+    TEST_ASSERT_EQUAL(0, profiler.elapsedUs());
+    BootProfiler::hook(&profiler, TRACE_END, CAL_OP_GET, "open");
+    TEST_ASSERT_EQUAL(profiler.record(0).totalUs, profiler.elapsedUs());
 }
 
 void setup() {
@@ -146,6 +1083,25 @@ void setup() {
     RUN_TEST(test_basic_operations);
     RUN_TEST(test_encryption);
     RUN_TEST(test_json_operations);
+    RUN_TEST(test_result_api);
+    RUN_TEST(test_transforms);
+    RUN_TEST(test_calibrated_channel);
+    RUN_TEST(test_calibration_table);
+    RUN_TEST(test_sample_accumulator);
+    RUN_TEST(test_robust_aggregation);
+    RUN_TEST(test_axis_calibration);
+    RUN_TEST(test_thermal_calibration);
+    RUN_TEST(test_color_calibration);
+    RUN_TEST(test_pipeline);
+    RUN_TEST(test_drift_monitor);
+    RUN_TEST(test_kalman_filter);
+    RUN_TEST(test_workflow);
+    RUN_TEST(test_encrypted_bundle);
+    RUN_TEST(test_deferred_log);
+    RUN_TEST(test_latency_histogram);
+    RUN_TEST(test_metrics);
+    RUN_TEST(test_trace_hooks);
+    RUN_TEST(test_boot_profiler);
     UNITY_END();
 }
 
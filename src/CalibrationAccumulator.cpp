@@ -0,0 +1,104 @@
+#include "CalibrationAccumulator.h"
+
+#if defined(ESP32)
+#define CAL_LOCK() portENTER_CRITICAL_SAFE(&_lock)
+#define CAL_UNLOCK() portEXIT_CRITICAL_SAFE(&_lock)
+#else
+#define CAL_LOCK()
+#define CAL_UNLOCK()
+#endif
+
+SampleAccumulator::SampleAccumulator(uint32_t targetCount) :
+    _target(targetCount),
+    _stableCount(0),
+    _maxVariance(0.0f) {
+#if defined(ESP32)
+    portMUX_TYPE unlocked = portMUX_INITIALIZER_UNLOCKED;
+    _lock = unlocked;
+#endif
+    reset();
+}
+
+void SampleAccumulator::setStabilityThreshold(float maxVariance, uint32_t minCount) {
+    _maxVariance = maxVariance;
+    _stableCount = minCount < 2 ? 2 : minCount;
+}
+
+void SampleAccumulator::reset() {
+    _count = 0;
+    _mean = 0.0;
+    _m2 = 0.0;
+    _min = INFINITY;
+    _max = -INFINITY;
+
+    CAL_LOCK();
+    _pendingCount = 0;
+    _pendingSum = 0;
+    _pendingSquares = 0;
+    _pendingMin = INT32_MAX;
+    _pendingMax = INT32_MIN;
+    CAL_UNLOCK();
+}
+
+void SampleAccumulator::add(float value) {
+    if (!isfinite(value)) {
+        return;
+    }
+    _count++;
+    double delta = value - _mean;
+    _mean += delta / _count;
+    _m2 += delta * (value - _mean);
+    if (value < _min) _min = value;
+    if (value > _max) _max = value;
+}
+
+void IRAM_ATTR SampleAccumulator::addFromISR(int32_t raw) {
+    CAL_LOCK();
+    _pendingCount = _pendingCount + 1;
+    _pendingSum = _pendingSum + raw;
+    _pendingSquares = _pendingSquares + (uint64_t)((int64_t)raw * raw);
+    if (raw < _pendingMin) _pendingMin = raw;
+    if (raw > _pendingMax) _pendingMax = raw;
+    CAL_UNLOCK();
+}
+
+void SampleAccumulator::update() {
+    CAL_LOCK();
+    uint32_t count = _pendingCount;
+    int64_t sum = _pendingSum;
+    uint64_t squares = _pendingSquares;
+    int32_t minValue = _pendingMin;
+    int32_t maxValue = _pendingMax;
+    _pendingCount = 0;
+    _pendingSum = 0;
+    _pendingSquares = 0;
+    _pendingMin = INT32_MAX;
+    _pendingMax = INT32_MIN;
+    CAL_UNLOCK();
+
+    if (count == 0) {
+        return;
+    }
+    double mean = (double)sum / count;
+    double m2 = (double)squares - (double)sum * mean;
+    merge(count, mean, m2 < 0.0 ? 0.0 : m2, minValue, maxValue);
+}
+
+// Combines another set of statistics (Chan et al. parallel update)
+void SampleAccumulator::merge(uint32_t count, double mean, double m2, float minValue, float maxValue) {
+    uint32_t total = _count + count;
+    double delta = mean - _mean;
+    _mean += delta * count / total;
+    _m2 += m2 + delta * delta * ((double)_count * count / total);
+    _count = total;
+    if (minValue < _min) _min = minValue;
+    if (maxValue > _max) _max = maxValue;
+}
+
+bool SampleAccumulator::isReady() {
+    update();
+    if (_target && _count >= _target) {
+        return true;
+    }
+    return _maxVariance > 0.0f && _count >= _stableCount && variance() <= _maxVariance;
+}
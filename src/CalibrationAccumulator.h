@@ -0,0 +1,78 @@
+#ifndef CALIBRATION_ACCUMULATOR_H
+#define CALIBRATION_ACCUMULATOR_H
+
+#include <Arduino.h>
+
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#endif
+
+// Running statistics for one calibration input, fed one sample at a time
+// from loop() instead of a blocking sampling loop. Mean and variance use
+// Welford's update, so no samples are stored.
+//
+//   SampleAccumulator pressure(100);      // ready after 100 samples
+//   void loop() {
+//       pressure.add(bme.readPressure() / 100.0f);
+//       if (pressure.isReady()) {
+//           calib.storeOffset("pressure_offset", pressure, 1013.25f);
+//           pressure.reset();
+//       }
+//   }
+//
+// Interrupt handlers use addFromISR(), which only touches integer sums
+// under a spinlock; they are folded in by update() or isReady().
+class SampleAccumulator {
+public:
+    explicit SampleAccumulator(uint32_t targetCount = 0);
+
+    // Ready once this many samples are in (0 disables the count target)
+    void setTarget(uint32_t count) { _target = count; }
+    // Also ready once at least minCount samples vary by no more than
+    // maxVariance, i.e. the input has settled (0 disables)
+    void setStabilityThreshold(float maxVariance, uint32_t minCount = 10);
+    void reset();
+
+    void add(float value);
+    void addFromISR(int32_t raw);
+
+    // Folds pending ISR samples into the statistics
+    void update();
+    // update() followed by the target and stability checks
+    bool isReady();
+
+    uint32_t count() const { return _count; }
+    float mean() const { return (float)_mean; }
+    // Sample variance (n - 1 denominator); 0 with fewer than two samples
+    float variance() const { return _count > 1 ? (float)(_m2 / (_count - 1)) : 0.0f; }
+    float stddev() const { return sqrtf(variance()); }
+    float minValue() const { return _min; }
+    float maxValue() const { return _max; }
+    // Correction that moves the mean onto the reference value
+    float offsetTo(float reference) const { return reference - mean(); }
+
+private:
+    void merge(uint32_t count, double mean, double m2, float minValue, float maxValue);
+
+    uint32_t _target;
+    uint32_t _stableCount;
+    float _maxVariance;
+
+    uint32_t _count;
+    double _mean;
+    double _m2;
+    float _min;
+    float _max;
+
+    // Integer staging area written by addFromISR()
+    volatile uint32_t _pendingCount;
+    volatile int64_t _pendingSum;
+    volatile uint64_t _pendingSquares;
+    volatile int32_t _pendingMin;
+    volatile int32_t _pendingMax;
+#if defined(ESP32)
+    portMUX_TYPE _lock;
+#endif
+};
+
+#endif
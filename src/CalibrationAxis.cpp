@@ -0,0 +1,391 @@
+#include "CalibrationAxis.h"
+#include "CalibrationFitter.h"
+
+static const uint8_t AXIS_MAGIC = 'A';
+static const uint8_t AXIS_VERSION = 1;
+
+AxisCalibration::AxisCalibration() {
+    setIdentity();
+}
+
+void AxisCalibration::setIdentity() {
+    memset(_bias, 0, sizeof(_bias));
+    memset(_matrix, 0, sizeof(_matrix));
+    _matrix[0] = _matrix[4] = _matrix[8] = 1.0f;
+    updateShift();
+}
+
+void AxisCalibration::setBias(const float bias[3]) {
+    memcpy(_bias, bias, sizeof(_bias));
+    updateShift();
+}
+
+void AxisCalibration::setMatrix(const float matrix[9]) {
+    memcpy(_matrix, matrix, sizeof(_matrix));
+    updateShift();
+}
+
+void AxisCalibration::updateShift() {
+    for (uint8_t row = 0; row < 3; row++) {
+        _shift[row] = _matrix[row * 3] * _bias[0] + _matrix[row * 3 + 1] * _bias[1] +
+                      _matrix[row * 3 + 2] * _bias[2];
+    }
+}
+
+void AxisCalibration::applyBatch(const float* raw, float* out, size_t count) const {
+    if (!raw || !out) {
+        return;
+    }
+    // Coefficients in locals so they stay in registers across the loop
+    const float m0 = _matrix[0], m1 = _matrix[1], m2 = _matrix[2];
+    const float m3 = _matrix[3], m4 = _matrix[4], m5 = _matrix[5];
+    const float m6 = _matrix[6], m7 = _matrix[7], m8 = _matrix[8];
+    const float s0 = _shift[0], s1 = _shift[1], s2 = _shift[2];
+    for (size_t i = 0; i < count; i++, raw += 3, out += 3) {
+        const float x = raw[0], y = raw[1], z = raw[2];
+        out[0] = m0 * x + m1 * y + m2 * z - s0;
+        out[1] = m3 * x + m4 * y + m5 * z - s1;
+        out[2] = m6 * x + m7 * y + m8 * z - s2;
+    }
+}
+
+void AxisCalibration::applyBatch(const int16_t* raw, float* out, size_t count) const {
+    if (!raw || !out) {
+        return;
+    }
+    const float m0 = _matrix[0], m1 = _matrix[1], m2 = _matrix[2];
+    const float m3 = _matrix[3], m4 = _matrix[4], m5 = _matrix[5];
+    const float m6 = _matrix[6], m7 = _matrix[7], m8 = _matrix[8];
+    const float s0 = _shift[0], s1 = _shift[1], s2 = _shift[2];
+    for (size_t i = 0; i < count; i++, raw += 3, out += 3) {
+        const float x = raw[0], y = raw[1], z = raw[2];
+        out[0] = m0 * x + m1 * y + m2 * z - s0;
+        out[1] = m3 * x + m4 * y + m5 * z - s1;
+        out[2] = m6 * x + m7 * y + m8 * z - s2;
+    }
+}
+
+size_t AxisCalibration::serialize(uint8_t* buffer, size_t size) const {
+    if (!buffer || size < SERIALIZED_SIZE) {
+        return 0;
+    }
+    buffer[0] = AXIS_MAGIC;
+    buffer[1] = AXIS_VERSION;
+    buffer[2] = 0;
+    buffer[3] = 0;
+    memcpy(buffer + 4, _bias, sizeof(_bias));
+    memcpy(buffer + 4 + sizeof(_bias), _matrix, sizeof(_matrix));
+    return SERIALIZED_SIZE;
+}
+
+bool AxisCalibration::deserialize(const uint8_t* buffer, size_t size) {
+    if (!buffer || size < SERIALIZED_SIZE ||
+        buffer[0] != AXIS_MAGIC || buffer[1] != AXIS_VERSION) {
+        return false;
+    }
+    memcpy(_bias, buffer + 4, sizeof(_bias));
+    memcpy(_matrix, buffer + 4 + sizeof(_bias), sizeof(_matrix));
+    updateShift();
+    return true;
+}
+
+AxisCalibrationFitter::AxisCalibrationFitter() {
+    reset();
+}
+
+void AxisCalibrationFitter::reset() {
+    _count = 0;
+    _faces = 0;
+    _weight = 0.0;
+    memset(_design, 0, sizeof(_design));
+    memset(_moments, 0, sizeof(_moments));
+    _referenceSquares = 0.0;
+}
+
+void AxisCalibrationFitter::addSample(const float raw[3], const float reference[3], float weight) {
+    if (!(weight > 0.0f)) {
+        return;
+    }
+    const double v[4] = {raw[0], raw[1], raw[2], 1.0};
+    for (uint8_t i = 0; i < 4; i++) {
+        for (uint8_t j = 0; j < 4; j++) {
+            _design[i * 4 + j] += weight * v[i] * v[j];
+        }
+    }
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        for (uint8_t j = 0; j < 4; j++) {
+            _moments[axis * 4 + j] += weight * reference[axis] * v[j];
+        }
+        _referenceSquares += weight * (double)reference[axis] * reference[axis];
+    }
+    _weight += weight;
+    _count++;
+}
+
+int8_t AxisCalibrationFitter::addGravitySample(const float raw[3], float gravity, float weight) {
+    uint8_t axis = 0;
+    for (uint8_t i = 1; i < 3; i++) {
+        if (fabsf(raw[i]) > fabsf(raw[axis])) {
+            axis = i;
+        }
+    }
+    // A resting accelerometer reads +g on the axis pointing up
+    float reference[3] = {0.0f, 0.0f, 0.0f};
+    reference[axis] = raw[axis] >= 0.0f ? gravity : -gravity;
+    addSample(raw, reference, weight);
+    _faces |= 1 << (axis * 2 + (raw[axis] >= 0.0f ? 0 : 1));
+    return raw[axis] >= 0.0f ? axis + 1 : -(axis + 1);
+}
+
+bool AxisCalibrationFitter::fit(AxisCalibration& calibration, float* rms) const {
+    if (_count < 4) {
+        return false;
+    }
+
+    // Each axis solves the same design matrix: reference_i = m_i . raw + c_i
+    double rows[3][4];
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        double a[16];
+        memcpy(a, _design, sizeof(a));
+        memcpy(rows[axis], _moments + axis * 4, sizeof(rows[axis]));
+        if (!solveLinearSystem(a, rows[axis], 4)) {
+            return false;
+        }
+    }
+
+    // corrected = M raw + c = M (raw - bias), so bias = -M^-1 c
+    double m[9];
+    double c[3];
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        for (uint8_t j = 0; j < 3; j++) {
+            m[axis * 3 + j] = rows[axis][j];
+        }
+        c[axis] = -rows[axis][3];
+    }
+    double inverse[9];
+    memcpy(inverse, m, sizeof(inverse));
+    if (!solveLinearSystem(inverse, c, 3)) {
+        return false;
+    }
+
+    if (rms) {
+        // RSS = sum w*|ref|^2 - 2 sum_i x_i . m_i + sum_i x_i^T D x_i
+        double rss = _referenceSquares;
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            const double* x = rows[axis];
+            for (uint8_t i = 0; i < 4; i++) {
+                rss -= 2.0 * x[i] * _moments[axis * 4 + i];
+                for (uint8_t j = 0; j < 4; j++) {
+                    rss += x[i] * x[j] * _design[i * 4 + j];
+                }
+            }
+        }
+        *rms = (float)sqrt((rss > 0.0 ? rss : 0.0) / (3.0 * _weight));
+    }
+
+    float matrix[9];
+    float bias[3];
+    for (uint8_t i = 0; i < 9; i++) {
+        matrix[i] = (float)m[i];
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+        bias[i] = (float)c[i];
+    }
+    calibration.setMatrix(matrix);
+    calibration.setBias(bias);
+    return true;
+}
+
+// Eigen decomposition of a symmetric 3x3 matrix by cyclic Jacobi rotations.
+// On return a holds the eigenvalues on its diagonal and v the eigenvectors
+// as columns.
+static void jacobiEigen(double a[9], double v[9]) {
+    memset(v, 0, 9 * sizeof(double));
+    v[0] = v[4] = v[8] = 1.0;
+    for (uint8_t sweep = 0; sweep < 32; sweep++) {
+        double off = a[1] * a[1] + a[2] * a[2] + a[5] * a[5];
+        if (off < 1e-30) {
+            break;
+        }
+        for (uint8_t p = 0; p < 2; p++) {
+            for (uint8_t q = p + 1; q < 3; q++) {
+                double apq = a[p * 3 + q];
+                if (fabs(apq) < 1e-300) {
+                    continue;
+                }
+                double theta = (a[q * 3 + q] - a[p * 3 + p]) / (2.0 * apq);
+                double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                double c = 1.0 / sqrt(t * t + 1.0);
+                double s = t * c;
+                for (uint8_t k = 0; k < 3; k++) {
+                    double akp = a[k * 3 + p];
+                    double akq = a[k * 3 + q];
+                    a[k * 3 + p] = c * akp - s * akq;
+                    a[k * 3 + q] = s * akp + c * akq;
+                }
+                for (uint8_t k = 0; k < 3; k++) {
+                    double apk = a[p * 3 + k];
+                    double aqk = a[q * 3 + k];
+                    a[p * 3 + k] = c * apk - s * aqk;
+                    a[q * 3 + k] = s * apk + c * aqk;
+                }
+                for (uint8_t k = 0; k < 3; k++) {
+                    double vkp = v[k * 3 + p];
+                    double vkq = v[k * 3 + q];
+                    v[k * 3 + p] = c * vkp - s * vkq;
+                    v[k * 3 + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+}
+
+// Index of (i, j), i <= j, in a packed upper triangle of a 9x9 matrix
+static inline uint8_t packedIndex(uint8_t i, uint8_t j) {
+    return i * 9 - i * (i + 1) / 2 + j;
+}
+
+EllipsoidFitter::EllipsoidFitter() :
+    _minSpacing(0.0f) {
+    reset();
+}
+
+void EllipsoidFitter::reset() {
+    _count = 0;
+    _scale = 1.0;
+    _octants = 0;
+    memset(_last, 0, sizeof(_last));
+    memset(_sum, 0, sizeof(_sum));
+    memset(_design, 0, sizeof(_design));
+    memset(_moments, 0, sizeof(_moments));
+}
+
+bool EllipsoidFitter::addSample(const float raw[3]) {
+    if (!isfinite(raw[0]) || !isfinite(raw[1]) || !isfinite(raw[2])) {
+        return false;
+    }
+    if (_count == 0) {
+        double norm = sqrt((double)raw[0] * raw[0] + (double)raw[1] * raw[1] + (double)raw[2] * raw[2]);
+        _scale = norm > 0.0 ? norm : 1.0;
+    } else if (_minSpacing > 0.0f) {
+        float dx = raw[0] - _last[0], dy = raw[1] - _last[1], dz = raw[2] - _last[2];
+        if (dx * dx + dy * dy + dz * dz < _minSpacing * _minSpacing) {
+            return false;
+        }
+    }
+    memcpy(_last, raw, sizeof(_last));
+
+    if (_count > 0) {
+        uint8_t octant = 0;
+        for (uint8_t k = 0; k < 3; k++) {
+            if (raw[k] >= _sum[k] / _count) octant |= 1 << k;
+        }
+        _octants |= 1 << octant;
+    }
+    for (uint8_t k = 0; k < 3; k++) {
+        _sum[k] += raw[k];
+    }
+
+    const double x = raw[0] / _scale, y = raw[1] / _scale, z = raw[2] / _scale;
+    const double d[9] = {x * x, y * y, z * z, 2 * x * y, 2 * x * z, 2 * y * z, 2 * x, 2 * y, 2 * z};
+    for (uint8_t i = 0; i < 9; i++) {
+        for (uint8_t j = i; j < 9; j++) {
+            _design[packedIndex(i, j)] += d[i] * d[j];
+        }
+        _moments[i] += d[i];
+    }
+    _count++;
+    return true;
+}
+
+float EllipsoidFitter::coverage() const {
+    return __builtin_popcount(_octants) / 8.0f;
+}
+
+bool EllipsoidFitter::fit(AxisCalibration& calibration, float fieldStrength, float* rms) const {
+    if (_count < 9) {
+        return false;
+    }
+
+    double normal[81];
+    double v[9];
+    for (uint8_t i = 0; i < 9; i++) {
+        for (uint8_t j = 0; j < 9; j++) {
+            normal[i * 9 + j] = _design[i <= j ? packedIndex(i, j) : packedIndex(j, i)];
+        }
+        v[i] = _moments[i];
+    }
+    if (!solveLinearSystem(normal, v, 9)) {
+        return false;
+    }
+
+    if (rms) {
+        // sum (D v - 1)^2 = v^T S v - 2 v . m + n
+        double rss = _count;
+        for (uint8_t i = 0; i < 9; i++) {
+            rss -= 2.0 * v[i] * _moments[i];
+            for (uint8_t j = 0; j < 9; j++) {
+                rss += v[i] * v[j] * _design[i <= j ? packedIndex(i, j) : packedIndex(j, i)];
+            }
+        }
+        *rms = (float)sqrt((rss > 0.0 ? rss : 0.0) / _count);
+    }
+
+    // Shape matrix and linear term of x^T A x + 2 b^T x = 1 (scaled units)
+    double shape[9] = {v[0], v[3], v[4], v[3], v[1], v[5], v[4], v[5], v[2]};
+    double center[3] = {-v[6], -v[7], -v[8]};
+    double a[9];
+    memcpy(a, shape, sizeof(a));
+    if (!solveLinearSystem(a, center, 3)) {
+        return false;
+    }
+
+    // (x - c)^T A (x - c) = 1 + c^T A c, so normalize A by that constant.
+    // When the origin lies outside the ellipsoid, A and the constant are
+    // both negative and the quotient is still positive definite.
+    double k = 1.0;
+    for (uint8_t i = 0; i < 3; i++) {
+        for (uint8_t j = 0; j < 3; j++) {
+            k += center[i] * shape[i * 3 + j] * center[j];
+        }
+    }
+    if (k == 0.0) {
+        return false;
+    }
+    for (uint8_t i = 0; i < 9; i++) {
+        shape[i] /= k;
+    }
+
+    // Symmetric square root via eigen decomposition; every eigenvalue must
+    // be positive or the readings did not describe an ellipsoid
+    double eigen[9];
+    double vectors[9];
+    memcpy(eigen, shape, sizeof(eigen));
+    jacobiEigen(eigen, vectors);
+    double roots[3];
+    for (uint8_t i = 0; i < 3; i++) {
+        if (!(eigen[i * 4] > 0.0)) {
+            return false;
+        }
+        roots[i] = sqrt(eigen[i * 4]);
+    }
+
+    // Default radius keeps the volume: the geometric mean of the semi-axes
+    double radius = fieldStrength > 0.0f ? fieldStrength : _scale / cbrt(roots[0] * roots[1] * roots[2]);
+
+    float matrix[9];
+    for (uint8_t i = 0; i < 3; i++) {
+        for (uint8_t j = 0; j < 3; j++) {
+            double sum = 0.0;
+            for (uint8_t e = 0; e < 3; e++) {
+                sum += vectors[i * 3 + e] * roots[e] * vectors[j * 3 + e];
+            }
+            // Input was divided by _scale before fitting
+            matrix[i * 3 + j] = (float)(sum * radius / _scale);
+        }
+    }
+    float bias[3] = {(float)(center[0] * _scale), (float)(center[1] * _scale), (float)(center[2] * _scale)};
+    calibration.setMatrix(matrix);
+    calibration.setBias(bias);
+    return true;
+}
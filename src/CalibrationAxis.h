@@ -0,0 +1,135 @@
+#ifndef CALIBRATION_AXIS_H
+#define CALIBRATION_AXIS_H
+
+#include <Arduino.h>
+
+// Three-axis sensor correction: corrected = matrix * (raw - bias). The
+// matrix combines per-axis scale, cross-axis misalignment and, for
+// magnetometers, soft-iron distortion; bias holds zero offsets or hard iron.
+class AxisCalibration {
+public:
+    static const size_t SERIALIZED_SIZE = 4 + 12 * sizeof(float);
+
+    AxisCalibration();
+
+    void setIdentity();
+    void setBias(const float bias[3]);
+    // Row-major 3x3
+    void setMatrix(const float matrix[9]);
+
+    const float* bias() const { return _bias; }
+    const float* matrix() const { return _matrix; }
+
+    // Applies in place when out == raw
+    inline void apply(const float raw[3], float out[3]) const {
+        const float x = raw[0], y = raw[1], z = raw[2];
+        out[0] = _matrix[0] * x + _matrix[1] * y + _matrix[2] * z - _shift[0];
+        out[1] = _matrix[3] * x + _matrix[4] * y + _matrix[5] * z - _shift[1];
+        out[2] = _matrix[6] * x + _matrix[7] * y + _matrix[8] * z - _shift[2];
+    }
+
+    // Corrects count interleaved x,y,z frames in one pass; out may alias raw
+    void applyBatch(const float* raw, float* out, size_t count) const;
+    // Same for raw integer sensor counts, e.g. MPU6050 register values
+    void applyBatch(const int16_t* raw, float* out, size_t count) const;
+
+    size_t serialize(uint8_t* buffer, size_t size) const;
+    bool deserialize(const uint8_t* buffer, size_t size);
+
+private:
+    void updateShift();
+
+    float _bias[3];
+    float _matrix[9];
+    float _shift[3];    // matrix * bias, folded so apply is one multiply-add pass
+};
+
+// Least-squares fit of an AxisCalibration from captures where the true
+// vector is known, such as an accelerometer resting in several
+// orientations. Every sample updates a 4x4 normal-equation sum shared by
+// the three axes, so no captures are stored.
+//
+//   AxisCalibrationFitter fitter;
+//   // rest the sensor on each of its six faces in turn
+//   fitter.addGravitySample(accel, 9.80665f);   // many samples per face
+//   AxisCalibration model;
+//   if (fitter.fit(model)) calib.storeAxisCalibration("accel", model);
+//
+// At least four orientations that are not coplanar are required; the six
+// faces of a box give a well-conditioned fit.
+class AxisCalibrationFitter {
+public:
+    AxisCalibrationFitter();
+
+    void reset();
+    void addSample(const float raw[3], const float reference[3], float weight = 1.0f);
+    // Uses the dominant axis of raw to decide which way is up, so the user
+    // only has to rest the sensor flat on each face. Returns that axis as
+    // 1..3 for +X..+Z or -1..-3 for -X..-Z.
+    int8_t addGravitySample(const float raw[3], float gravity = 9.80665f, float weight = 1.0f);
+
+    uint32_t count() const { return _count; }
+    // Bit mask of the six faces seen so far by addGravitySample (bit 0 = +X,
+    // bit 1 = -X, ... bit 5 = -Z)
+    uint8_t facesSeen() const { return _faces; }
+
+    // rms receives the root mean square residual of the fitted samples
+    bool fit(AxisCalibration& calibration, float* rms = nullptr) const;
+
+private:
+    uint32_t _count;
+    uint8_t _faces;
+    double _weight;
+    double _design[16];     // sum w * [raw 1]^T [raw 1]
+    double _moments[12];    // sum w * reference_i * [raw 1], one row per axis
+    double _referenceSquares;
+};
+
+// Streaming hard- and soft-iron fit for magnetometers. While the device
+// is turned through as many orientations as possible, each reading updates
+// the normal-equation sums of the general ellipsoid
+//
+//   a x^2 + b y^2 + c z^2 + 2d xy + 2e xz + 2f yz + 2g x + 2h y + 2i z = 1
+//
+// (45 + 9 running sums, no sample buffer). fit() recovers the centre (hard
+// iron) and the symmetric square root of the shape matrix (soft iron) as
+// an AxisCalibration that maps readings onto a sphere.
+//
+//   EllipsoidFitter fitter;
+//   // while the user rotates the board:
+//   fitter.addSample(mag);
+//   AxisCalibration model;
+//   if (fitter.fit(model)) calib.storeAxisCalibration("mag", model);
+class EllipsoidFitter {
+public:
+    EllipsoidFitter();
+
+    void reset();
+    // Readings closer than this to the previously accepted one are
+    // skipped, so time spent holding still does not dominate the fit
+    void setMinSpacing(float distance) { _minSpacing = distance; }
+    // Returns true if the reading was accepted
+    bool addSample(const float raw[3]);
+
+    uint32_t count() const { return _count; }
+    // Share of the 8 octants around the running mean that have been
+    // visited; sweeping back and forth fills it faster than one slow turn
+    float coverage() const;
+
+    // fieldStrength sets the radius of the corrected sphere, e.g. the local
+    // field in uT; 0 keeps the fitted ellipsoid's mean radius. rms receives
+    // the RMS algebraic residual, roughly twice the relative radius error.
+    bool fit(AxisCalibration& calibration, float fieldStrength = 0.0f, float* rms = nullptr) const;
+
+private:
+    uint32_t _count;
+    float _minSpacing;
+    float _last[3];
+    double _scale;          // inputs are divided by this to keep sums well conditioned
+    double _sum[3];         // running mean for coverage()
+    uint8_t _octants;
+    double _design[45];     // upper triangle of sum D^T D
+    double _moments[9];     // sum D
+};
+
+#endif
@@ -0,0 +1,28 @@
+#include "CalibrationChannel.h"
+
+bool IdentityModel::load(const CalibrationTransform& transform) {
+    return transform.type() == TRANSFORM_IDENTITY;
+}
+
+void IdentityModel::store(CalibrationTransform& transform) const {
+    transform.setIdentity();
+}
+
+bool LinearModel::load(const CalibrationTransform& transform) {
+    switch (transform.type()) {
+        case TRANSFORM_IDENTITY:
+            scale = 1.0f;
+            offset = 0.0f;
+            return true;
+        case TRANSFORM_LINEAR:
+            scale = transform.scale();
+            offset = transform.offset();
+            return true;
+        default:
+            return false;
+    }
+}
+
+void LinearModel::store(CalibrationTransform& transform) const {
+    transform.setLinear(scale, offset);
+}
@@ -0,0 +1,232 @@
+#ifndef CALIBRATION_CHANNEL_H
+#define CALIBRATION_CHANNEL_H
+
+#include <limits>
+#include <type_traits>
+#include "CalibrationLib.h"
+
+// Models with the kind and size fixed at compile time. Each one converts
+// from and to CalibrationTransform, so channels share the stored format
+// with workflows and fitters, and each apply() has no type switch and
+// loops whose bounds are constants the compiler can unroll.
+
+struct IdentityModel {
+    // Accepts identity transforms only
+    bool load(const CalibrationTransform& transform);
+    void store(CalibrationTransform& transform) const;
+    inline float apply(float raw) const { return raw; }
+};
+
+struct LinearModel {
+    float scale;
+    float offset;
+
+    LinearModel() : scale(1.0f), offset(0.0f) {}
+    // Accepts identity and linear transforms
+    bool load(const CalibrationTransform& transform);
+    void store(CalibrationTransform& transform) const;
+    inline float apply(float raw) const { return raw * scale + offset; }
+};
+
+// Polynomials up to Degree; lower-degree and linear transforms load with
+// the upper terms zeroed
+template <uint8_t Degree>
+struct PolynomialModel {
+    static_assert(Degree >= 1 && Degree <= CALIBRATION_MAX_POLY_DEGREE, "PolynomialModel: unsupported degree");
+
+    float coefficients[Degree + 1];   // coefficients[i] multiplies u^i
+    float center;                     // u = (raw - center) * inverseRange
+    float inverseRange;
+
+    PolynomialModel() : center(0.0f), inverseRange(1.0f) {
+        for (uint8_t i = 0; i <= Degree; i++) {
+            coefficients[i] = i == 1 ? 1.0f : 0.0f;
+        }
+    }
+
+    bool load(const CalibrationTransform& transform) {
+        const TransformType type = transform.type();
+        if (type == TRANSFORM_PIECEWISE || (type == TRANSFORM_POLYNOMIAL && transform.size() > Degree)) {
+            return false;
+        }
+        if (type == TRANSFORM_IDENTITY) {
+            *this = PolynomialModel();
+            return true;
+        }
+        // Linear transforms keep offset and scale in the first two terms too
+        const uint8_t degree = type == TRANSFORM_LINEAR ? 1 : transform.size();
+        center = transform.center();
+        inverseRange = transform.inverseRange();
+        for (uint8_t i = 0; i <= Degree; i++) {
+            coefficients[i] = i <= degree ? transform.coefficient(i) : 0.0f;
+        }
+        return true;
+    }
+
+    void store(CalibrationTransform& transform) const {
+        transform.setPolynomial(coefficients, Degree, center, inverseRange);
+    }
+
+    inline float apply(float raw) const {
+        const float u = (raw - center) * inverseRange;
+        float y = coefficients[Degree];
+        for (int8_t i = Degree - 1; i >= 0; i--) {
+            y = y * u + coefficients[i];
+        }
+        return y;
+    }
+};
+
+// Piecewise-linear tables of up to Points breakpoints. Shorter tables are
+// padded by repeating the last breakpoint with the last slope, so the
+// search always runs over Points entries and extrapolation is unchanged.
+template <uint8_t Points>
+struct PiecewiseModel {
+    static_assert(Points >= 2 && Points <= CALIBRATION_MAX_TABLE_POINTS, "PiecewiseModel: unsupported size");
+
+    float raw[Points];
+    float values[Points];
+    float slopes[Points];
+    uint8_t count;   // breakpoints before padding
+
+    // Identity over Points breakpoints
+    PiecewiseModel() : count(Points) {
+        for (uint8_t i = 0; i < Points; i++) {
+            raw[i] = i;
+            values[i] = i;
+            slopes[i] = 1.0f;
+        }
+    }
+
+    bool load(const CalibrationTransform& transform) {
+        if (transform.type() != TRANSFORM_PIECEWISE || transform.size() < 2 || transform.size() > Points) {
+            return false;
+        }
+        count = transform.size();
+        for (uint8_t i = 0; i < count; i++) {
+            raw[i] = transform.point(i);
+            values[i] = transform.coefficient(i);
+        }
+        for (uint8_t i = 0; i + 1 < count; i++) {
+            slopes[i] = (values[i + 1] - values[i]) / (raw[i + 1] - raw[i]);
+        }
+        for (uint8_t i = count - 1; i < Points; i++) {
+            raw[i] = raw[count - 1];
+            values[i] = values[count - 1];
+            slopes[i] = slopes[count - 2];
+        }
+        return true;
+    }
+
+    void store(CalibrationTransform& transform) const {
+        transform.setPiecewise(raw, values, count);
+    }
+
+    inline float apply(float x) const {
+        // Same branchless search as CalibrationTransform, over a constant length
+        const float* base = raw;
+        uint8_t length = Points - 1;
+        while (length > 1) {
+            uint8_t half = length / 2;
+            base = (base[half] <= x) ? base + half : base;
+            length -= half;
+        }
+        const uint8_t i = base - raw;
+        return values[i] + (x - raw[i]) * slopes[i];
+    }
+};
+
+// Converts a model result to the channel's output type: floating types
+// pass through, integers are rounded to nearest and saturated, and NaN
+// maps to 0 since it has no integer value
+template <typename OutT, bool Integral = std::is_integral<OutT>::value>
+struct ChannelOutput {
+    static inline OutT convert(float value) { return (OutT)value; }
+};
+
+template <typename OutT>
+struct ChannelOutput<OutT, true> {
+    static inline OutT convert(float value) {
+        if (isnan(value)) return 0;
+        const float low = (float)std::numeric_limits<OutT>::lowest();
+        const float high = (float)std::numeric_limits<OutT>::max();
+        if (value <= low) return std::numeric_limits<OutT>::lowest();
+        if (value >= high) return std::numeric_limits<OutT>::max();
+        return (OutT)(value + (value >= 0.0f ? 0.5f : -0.5f));
+    }
+};
+
+// One calibrated input bound to its storage key. The model type is part of
+// the channel type, so apply() compiles to the model's arithmetic alone;
+// CalibrationTransform remains the choice when the model is only known at
+// run time.
+//
+//   CalibratedChannel<LinearModel, int16_t, int16_t> battery("batt_model");
+//   CalibratedChannel<PolynomialModel<3>> thermistor("ntc_model");
+//   CalibratedChannel<PiecewiseModel<8>> flow("flow_model");
+//
+//   loadChannels(calib, battery, thermistor, flow);
+//   int16_t millivolts = battery.apply(analogRead(35));
+template <typename Model, typename InT = int16_t, typename OutT = float>
+class CalibratedChannel {
+public:
+    explicit CalibratedChannel(const char* key) : _key(key) {}
+
+    const char* key() const { return _key; }
+    Model& model() { return _model; }
+    const Model& model() const { return _model; }
+
+    // Loads the transform stored under key(); CAL_READ_ERROR when it does
+    // not fit the model, leaving the model unchanged
+    CalibrationError load(CalibrationLib& calibration) {
+        CalibrationTransform transform;
+        CalibrationError error = calibration.loadTransform(_key, transform);
+        if (error != CAL_OK) {
+            return error;
+        }
+        Model model;
+        if (!model.load(transform)) {
+            return CAL_READ_ERROR;
+        }
+        _model = model;
+        return CAL_OK;
+    }
+
+    CalibrationError store(CalibrationLib& calibration) const {
+        CalibrationTransform transform;
+        _model.store(transform);
+        return calibration.storeTransform(_key, transform);
+    }
+
+    inline OutT apply(InT raw) const {
+        return ChannelOutput<OutT>::convert(_model.apply((float)raw));
+    }
+
+    void applyBatch(const InT* raw, OutT* out, size_t count) const {
+        // A local copy cannot alias out, so the coefficients stay in registers
+        const Model model = _model;
+        for (size_t i = 0; i < count; i++) {
+            out[i] = ChannelOutput<OutT>::convert(model.apply((float)raw[i]));
+        }
+    }
+
+private:
+    const char* _key;
+    Model _model;
+};
+
+// Loads every channel and returns the first error; all channels are
+// attempted even if one fails
+inline CalibrationError loadChannels(CalibrationLib& calibration) {
+    (void)calibration;
+    return CAL_OK;
+}
+
+template <typename Channel, typename... Rest>
+CalibrationError loadChannels(CalibrationLib& calibration, Channel& channel, Rest&... rest) {
+    CalibrationError error = channel.load(calibration);
+    CalibrationError restError = loadChannels(calibration, rest...);
+    return error != CAL_OK ? error : restError;
+}
+
+#endif
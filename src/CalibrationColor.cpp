@@ -0,0 +1,160 @@
+#include "CalibrationColor.h"
+
+// Serialized layout: magic, version, two reserved bytes, then gains,
+// gammas and the row-major matrix as floats
+static const uint8_t COLOR_MAGIC = 'C';
+static const uint8_t COLOR_VERSION = 1;
+
+ColorCalibration::ColorCalibration() {
+    setIdentity();
+}
+
+void ColorCalibration::setIdentity() {
+    for (uint8_t c = 0; c < 3; c++) {
+        _gain[c] = 1.0f;
+        _gamma[c] = 1.0f;
+    }
+    memset(_matrix, 0, sizeof(_matrix));
+    _matrix[0] = _matrix[4] = _matrix[8] = 1.0f;
+}
+
+void ColorCalibration::setGain(float red, float green, float blue) {
+    _gain[0] = red;
+    _gain[1] = green;
+    _gain[2] = blue;
+}
+
+void ColorCalibration::setGamma(float red, float green, float blue) {
+    _gamma[0] = red;
+    _gamma[1] = green;
+    _gamma[2] = blue;
+}
+
+void ColorCalibration::setMatrix(const float matrix[9]) {
+    memcpy(_matrix, matrix, sizeof(_matrix));
+}
+
+bool ColorCalibration::hasCrossTerms() const {
+    for (uint8_t i = 0; i < 9; i++) {
+        if (i % 4 != 0 && _matrix[i] != 0.0f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ColorCalibration::apply(uint8_t red, uint8_t green, uint8_t blue, float duty[3]) const {
+    const uint8_t levels[3] = {red, green, blue};
+    float linear[3];
+    for (uint8_t c = 0; c < 3; c++) {
+        linear[c] = powf(levels[c] / 255.0f, _gamma[c]);
+    }
+    for (uint8_t c = 0; c < 3; c++) {
+        const float* row = _matrix + c * 3;
+        float value = _gain[c] * (row[0] * linear[0] + row[1] * linear[1] + row[2] * linear[2]);
+        duty[c] = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    }
+}
+
+size_t ColorCalibration::serialize(uint8_t* buffer, size_t size) const {
+    if (!buffer || size < SERIALIZED_SIZE) {
+        return 0;
+    }
+    buffer[0] = COLOR_MAGIC;
+    buffer[1] = COLOR_VERSION;
+    buffer[2] = 0;
+    buffer[3] = 0;
+    memcpy(buffer + 4, _gain, sizeof(_gain));
+    memcpy(buffer + 4 + sizeof(_gain), _gamma, sizeof(_gamma));
+    memcpy(buffer + 4 + sizeof(_gain) + sizeof(_gamma), _matrix, sizeof(_matrix));
+    return SERIALIZED_SIZE;
+}
+
+bool ColorCalibration::deserialize(const uint8_t* buffer, size_t size) {
+    if (!buffer || size < SERIALIZED_SIZE ||
+        buffer[0] != COLOR_MAGIC || buffer[1] != COLOR_VERSION) {
+        return false;
+    }
+    memcpy(_gain, buffer + 4, sizeof(_gain));
+    memcpy(_gamma, buffer + 4 + sizeof(_gain), sizeof(_gamma));
+    memcpy(_matrix, buffer + 4 + sizeof(_gain) + sizeof(_gamma), sizeof(_matrix));
+    return true;
+}
+
+ColorLUT::ColorLUT() : _round(0), _shift(0), _outputBits(0), _maxDuty(0), _mix(false) {
+    memset(_tables, 0, sizeof(_tables));
+    memset(_coefficients, 0, sizeof(_coefficients));
+}
+
+bool ColorLUT::build(const ColorCalibration& calibration, uint8_t outputBits) {
+    if (outputBits == 0 || outputBits > MAX_OUTPUT_BITS) {
+        return false;
+    }
+    const float* gain = calibration.gain();
+    const float* gamma = calibration.gamma();
+    const float* matrix = calibration.matrix();
+    const uint16_t maxDuty = (1UL << outputBits) - 1;
+    const bool mix = calibration.hasCrossTerms();
+
+    int32_t coefficients[9] = {0};
+    uint8_t shift = 0;
+    if (mix) {
+        // Largest shift that keeps every product below 2^29, so the sum of
+        // three stays clear of int32 overflow
+        float largest = 0.0f;
+        float scaled[9];
+        for (uint8_t i = 0; i < 9; i++) {
+            scaled[i] = gain[i / 3] * matrix[i] * maxDuty / (1UL << LINEAR_BITS);
+            float magnitude = fabsf(scaled[i]);
+            if (magnitude > largest) largest = magnitude;
+        }
+        if (!(largest < (1UL << 14))) {
+            return false;
+        }
+        while (shift < 30 && largest * (1UL << (shift + 1)) < (1UL << 14)) {
+            shift++;
+        }
+        for (uint8_t i = 0; i < 9; i++) {
+            coefficients[i] = (int32_t)lroundf(scaled[i] * (1UL << shift));
+        }
+    }
+
+    for (uint8_t c = 0; c < 3; c++) {
+        // A diagonal matrix entry is just another per-channel gain
+        const float scale = mix ? (float)(1UL << LINEAR_BITS) : gain[c] * matrix[c * 4] * maxDuty;
+        const float limit = mix ? (float)(1UL << LINEAR_BITS) : (float)maxDuty;
+        for (uint16_t v = 0; v < 256; v++) {
+            float value = powf(v / 255.0f, gamma[c]) * scale;
+            value = value < 0.0f ? 0.0f : (value > limit ? limit : value);
+            _tables[c][v] = (uint16_t)(value + 0.5f);
+        }
+    }
+
+    memcpy(_coefficients, coefficients, sizeof(_coefficients));
+    _shift = shift;
+    _round = shift ? 1L << (shift - 1) : 0;
+    _maxDuty = maxDuty;
+    _outputBits = outputBits;
+    _mix = mix;
+    return true;
+}
+
+void ColorLUT::applyBatch(const uint8_t* rgb, uint16_t* duty, size_t count) const {
+    if (!rgb || !duty) {
+        return;
+    }
+    if (!_mix) {
+        const uint16_t* red = _tables[0];
+        const uint16_t* green = _tables[1];
+        const uint16_t* blue = _tables[2];
+        for (size_t i = 0; i < count; i++, rgb += 3, duty += 3) {
+            duty[0] = red[rgb[0]];
+            duty[1] = green[rgb[1]];
+            duty[2] = blue[rgb[2]];
+        }
+        return;
+    }
+    for (size_t i = 0; i < count; i++, rgb += 3, duty += 3) {
+        apply(rgb[0], rgb[1], rgb[2], duty);
+    }
+}
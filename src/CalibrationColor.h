@@ -0,0 +1,116 @@
+#ifndef CALIBRATION_COLOR_H
+#define CALIBRATION_COLOR_H
+
+#include <Arduino.h>
+
+// Color model for one RGB LED. An 8-bit input level v on channel c is
+// first linearized with the channel's gamma, lin = (v / 255)^gamma, then
+// mixed in linear light by the 3x3 white-balance matrix and scaled by the
+// channel gain:
+//
+//   duty[c] = gain[c] * sum_j matrix[c][j] * lin[j]      (0..1 of full PWM)
+//
+// With the default identity matrix this is a per-channel gain and gamma.
+class ColorCalibration {
+public:
+    static const size_t SERIALIZED_SIZE = 4 + 15 * sizeof(float);
+
+    ColorCalibration();
+
+    // Gain 1, gamma 1 (no correction), identity matrix
+    void setIdentity();
+    void setGain(float red, float green, float blue);
+    void setGamma(float gamma) { setGamma(gamma, gamma, gamma); }
+    void setGamma(float red, float green, float blue);
+    // Row-major 3x3 in linear light
+    void setMatrix(const float matrix[9]);
+
+    const float* gain() const { return _gain; }
+    const float* gamma() const { return _gamma; }
+    const float* matrix() const { return _matrix; }
+    // True if the matrix mixes channels, i.e. has off-diagonal terms
+    bool hasCrossTerms() const;
+
+    // Reference evaluation in float, 0..1 of full scale per channel
+    void apply(uint8_t red, uint8_t green, uint8_t blue, float duty[3]) const;
+
+    size_t serialize(uint8_t* buffer, size_t size) const;
+    bool deserialize(const uint8_t* buffer, size_t size);
+
+private:
+    float _gain[3];
+    float _gamma[3];
+    float _matrix[9];
+};
+
+// A ColorCalibration compiled into per-channel integer tables sized to the
+// PWM resolution, so setting a color needs no floating point:
+//
+//   ColorCalibration model;
+//   model.setGain(1.0f, 0.82f, 0.9f);
+//   model.setGamma(2.2f);
+//   ColorLUT lut;
+//   lut.build(model, 12);              // ledcSetup(..., 12)
+//   uint16_t duty[3];
+//   lut.apply(r, g, b, duty);          // three table loads
+//
+// Gain and a diagonal matrix are folded into the tables. When the matrix
+// has cross terms the tables hold linear light instead, and apply() mixes
+// them with nine integer multiply-adds; above 12-bit output the Q15
+// linear tables then limit accuracy to a few counts. The tables take 1.5KB and are
+// stored inline, so apply() is safe from ISRs and timer callbacks.
+class ColorLUT {
+public:
+    static const uint8_t MAX_OUTPUT_BITS = 16;
+
+    ColorLUT();
+
+    bool build(const ColorCalibration& calibration, uint8_t outputBits = 8);
+
+    bool isValid() const { return _outputBits != 0; }
+    uint8_t outputBits() const { return _outputBits; }
+    uint16_t maxDuty() const { return _maxDuty; }
+    bool mixesChannels() const { return _mix; }
+
+    inline void apply(uint8_t red, uint8_t green, uint8_t blue, uint16_t duty[3]) const {
+        if (!_mix) {
+            duty[0] = _tables[0][red];
+            duty[1] = _tables[1][green];
+            duty[2] = _tables[2][blue];
+            return;
+        }
+        const int32_t r = _tables[0][red], g = _tables[1][green], b = _tables[2][blue];
+        for (uint8_t c = 0; c < 3; c++) {
+            const int32_t* k = _coefficients + c * 3;
+            int32_t value = (k[0] * r + k[1] * g + k[2] * b + _round) >> _shift;
+            duty[c] = value < 0 ? 0 : (value > _maxDuty ? _maxDuty : value);
+        }
+    }
+
+    // Duty for one channel on its own. Only exact when the matrix has no
+    // cross terms; otherwise returns the channel's linear level scaled to
+    // full PWM.
+    inline uint16_t channel(uint8_t index, uint8_t value) const {
+        if (!_mix) {
+            return _tables[index][value];
+        }
+        return ((uint32_t)_tables[index][value] * _maxDuty) >> LINEAR_BITS;
+    }
+
+    // Converts count packed r,g,b pixels into r,g,b duty triples
+    void applyBatch(const uint8_t* rgb, uint16_t* duty, size_t count) const;
+
+private:
+    // Linear-light table precision when mixing channels (Q15)
+    static const uint8_t LINEAR_BITS = 15;
+
+    uint16_t _tables[3][256];
+    int32_t _coefficients[9];   // gain * matrix * maxDuty in Q(_shift)
+    int32_t _round;             // half of the last shifted-out bit
+    uint8_t _shift;
+    uint8_t _outputBits;
+    uint16_t _maxDuty;
+    bool _mix;
+};
+
+#endif
@@ -0,0 +1,198 @@
+#include "CalibrationDrift.h"
+
+// Serialized layout: magic, version, two reserved bytes, then checks,
+// bias, mean square and operating seconds as 32-bit values
+static const uint8_t DRIFT_MAGIC = 'D';
+static const uint8_t DRIFT_VERSION = 1;
+
+DriftMonitor::DriftMonitor(float tolerance, float alpha) :
+    _tolerance(tolerance),
+    _minChecks(3) {
+    setAlpha(alpha);
+    reset();
+}
+
+void DriftMonitor::setAlpha(float alpha) {
+    _alpha = alpha <= 0.0f ? 0.05f : (alpha > 1.0f ? 1.0f : alpha);
+}
+
+void DriftMonitor::reset() {
+    _checks = 0;
+    _bias = 0.0f;
+    _meanSquare = 0.0f;
+    _last = 0.0f;
+    _operatingSeconds = 0;
+}
+
+void DriftMonitor::addCheck(float measured, float reference) {
+    const float residual = measured - reference;
+    _last = residual;
+    _checks++;
+    // Plain running mean until 1/alpha checks are in, so the first few do
+    // not start from an arbitrary zero
+    float weight = 1.0f / _checks;
+    if (weight < _alpha) {
+        weight = _alpha;
+    }
+    _bias += weight * (residual - _bias);
+    _meanSquare += weight * (residual * residual - _meanSquare);
+}
+
+float DriftMonitor::noise() const {
+    float variance = _meanSquare - _bias * _bias;
+    return variance > 0.0f ? sqrtf(variance) : 0.0f;
+}
+
+size_t DriftMonitor::serialize(uint8_t* buffer, size_t size) const {
+    if (!buffer || size < SERIALIZED_SIZE) {
+        return 0;
+    }
+    buffer[0] = DRIFT_MAGIC;
+    buffer[1] = DRIFT_VERSION;
+    buffer[2] = 0;
+    buffer[3] = 0;
+    memcpy(buffer + 4, &_checks, sizeof(uint32_t));
+    memcpy(buffer + 8, &_bias, sizeof(float));
+    memcpy(buffer + 12, &_meanSquare, sizeof(float));
+    memcpy(buffer + 16, &_operatingSeconds, sizeof(uint32_t));
+    return SERIALIZED_SIZE;
+}
+
+bool DriftMonitor::deserialize(const uint8_t* buffer, size_t size) {
+    if (!buffer || size < SERIALIZED_SIZE ||
+        buffer[0] != DRIFT_MAGIC || buffer[1] != DRIFT_VERSION) {
+        return false;
+    }
+    memcpy(&_checks, buffer + 4, sizeof(uint32_t));
+    memcpy(&_bias, buffer + 8, sizeof(float));
+    memcpy(&_meanSquare, buffer + 12, sizeof(float));
+    memcpy(&_operatingSeconds, buffer + 16, sizeof(uint32_t));
+    _last = 0.0f;
+    return true;
+}
+
+RecalibrationScheduler::RecalibrationScheduler() :
+    _count(0),
+    _started(false),
+    _lastMs(0),
+    _pendingMs(0) {
+}
+
+int8_t RecalibrationScheduler::addChannel(const char* name, DriftMonitor& monitor, uint8_t weight,
+                                          uint32_t maxAgeSeconds) {
+    if (!name || _count >= MAX_CHANNELS) {
+        return -1;
+    }
+    Channel& channel = _channels[_count];
+    channel.name = name;
+    channel.monitor = &monitor;
+    channel.weight = weight ? weight : 1;
+    channel.maxAgeSeconds = maxAgeSeconds;
+    return _count++;
+}
+
+void RecalibrationScheduler::update() {
+    update(millis());
+}
+
+void RecalibrationScheduler::update(uint32_t nowMs) {
+    if (!_started) {
+        _started = true;
+        _lastMs = nowMs;
+        return;
+    }
+    // Unsigned subtraction handles millis() wrap-around
+    _pendingMs += nowMs - _lastMs;
+    _lastMs = nowMs;
+    if (_pendingMs < 1000) {
+        return;
+    }
+    uint32_t seconds = _pendingMs / 1000;
+    _pendingMs -= seconds * 1000;
+    for (uint8_t i = 0; i < _count; i++) {
+        _channels[i].monitor->addOperatingTime(seconds);
+    }
+}
+
+int8_t RecalibrationScheduler::find(const char* name) const {
+    if (!name) {
+        return -1;
+    }
+    for (uint8_t i = 0; i < _count; i++) {
+        if (strcmp(_channels[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+float RecalibrationScheduler::ageScore(const Channel& channel) const {
+    if (channel.maxAgeSeconds == 0) {
+        return 0.0f;
+    }
+    return (float)channel.monitor->operatingSeconds() / channel.maxAgeSeconds;
+}
+
+bool RecalibrationScheduler::isDue(uint8_t channel) const {
+    if (channel >= _count) {
+        return false;
+    }
+    const Channel& c = _channels[channel];
+    return c.monitor->needsRecalibration() || ageScore(c) >= 1.0f;
+}
+
+float RecalibrationScheduler::priority(uint8_t channel) const {
+    if (channel >= _count) {
+        return 0.0f;
+    }
+    const Channel& c = _channels[channel];
+    float drift = c.monitor->driftScore();
+    if (drift > 1.0f && !c.monitor->needsRecalibration()) {
+        drift = 1.0f;   // too few checks to trust yet: approaching, not due
+    }
+    float age = ageScore(c);
+    return c.weight * (drift > age ? drift : age);
+}
+
+uint8_t RecalibrationScheduler::dueCount() const {
+    uint8_t due = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (isDue(i)) {
+            due++;
+        }
+    }
+    return due;
+}
+
+int8_t RecalibrationScheduler::next() const {
+    int8_t best = -1;
+    float bestPriority = 0.0f;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (!isDue(i)) {
+            continue;
+        }
+        float p = priority(i);
+        if (best < 0 || p > bestPriority) {
+            best = i;
+            bestPriority = p;
+        }
+    }
+    return best;
+}
+
+void RecalibrationScheduler::markRecalibrated(uint8_t channel) {
+    if (channel < _count) {
+        _channels[channel].monitor->reset();
+    }
+}
+
+void RecalibrationScheduler::printReport(Print& output) const {
+    output.println("Channel          checks       bias      noise    age(h)  priority");
+    for (uint8_t i = 0; i < _count; i++) {
+        const Channel& c = _channels[i];
+        const DriftMonitor& m = *c.monitor;
+        output.printf("%-15s %7lu %10.4f %10.4f %9.1f %9.2f%s\n", c.name, (unsigned long)m.checks(),
+                      m.bias(), m.noise(), m.operatingSeconds() / 3600.0f, priority(i),
+                      isDue(i) ? "  DUE" : "");
+    }
+}
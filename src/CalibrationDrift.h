@@ -0,0 +1,135 @@
+#ifndef CALIBRATION_DRIFT_H
+#define CALIBRATION_DRIFT_H
+
+#include <Arduino.h>
+
+// Channels one RecalibrationScheduler can rank
+#ifndef CALIBRATION_MAX_DRIFT_CHANNELS
+#define CALIBRATION_MAX_DRIFT_CHANNELS 8
+#endif
+
+// Tracks how far one calibrated channel has drifted. Each check compares
+// a calibrated reading with something known: a reference value (a resting
+// gyro reads zero, a resting accelerometer reads 1 g) or a second sensor
+// measuring the same quantity. The residuals feed exponentially weighted
+// estimates of the bias and noise, so recent checks count most.
+//
+//   DriftMonitor gyroDrift(0.02f);          // tolerate 0.02 rad/s
+//   if (boardIsStill) gyroDrift.addCheck(gyroRate, 0.0f);
+//   if (gyroDrift.needsRecalibration()) ...
+//
+// Operating time since the last calibration is accumulated explicitly and
+// stored with the monitor, so unlike millis() it survives reboots.
+class DriftMonitor {
+public:
+    static const size_t SERIALIZED_SIZE = 4 + 4 * sizeof(uint32_t);
+
+    // tolerance: largest acceptable |bias| in output units (0 never flags).
+    // alpha: weight of each new check once enough have been seen.
+    explicit DriftMonitor(float tolerance = 0.0f, float alpha = 0.05f);
+
+    void setTolerance(float tolerance) { _tolerance = tolerance; }
+    void setAlpha(float alpha);
+    // Checks required before drift can be flagged (default 3)
+    void setMinChecks(uint16_t count) { _minChecks = count; }
+    // Call after recalibrating; clears the residuals and operating time
+    void reset();
+
+    void addCheck(float measured, float reference);
+    // Cross-sensor agreement: the residual is measured - other
+    void addAgreement(float measured, float other) { addCheck(measured, other); }
+    void addOperatingTime(uint32_t seconds) { _operatingSeconds += seconds; }
+
+    uint32_t checks() const { return _checks; }
+    // Weighted mean residual; the correction that would remove it is -bias()
+    float bias() const { return _bias; }
+    // Weighted standard deviation of the residuals
+    float noise() const;
+    float lastResidual() const { return _last; }
+    uint32_t operatingSeconds() const { return _operatingSeconds; }
+    // |bias| / tolerance: 1 is the edge of tolerance
+    float driftScore() const { return _tolerance > 0.0f ? fabsf(_bias) / _tolerance : 0.0f; }
+    bool needsRecalibration() const { return _checks >= _minChecks && driftScore() > 1.0f; }
+
+    // Residual state and operating time; tolerance and weights stay in code
+    size_t serialize(uint8_t* buffer, size_t size) const;
+    bool deserialize(const uint8_t* buffer, size_t size);
+
+private:
+    float _tolerance;
+    float _alpha;
+    uint16_t _minChecks;
+    uint32_t _checks;
+    float _bias;
+    float _meanSquare;
+    float _last;
+    uint32_t _operatingSeconds;
+};
+
+// Ranks monitored channels so recalibration effort goes where drift
+// actually happened. A channel is due when its monitor flags drift or its
+// operating time passes maxAgeSeconds; due channels are ordered by
+// weight * max(drift score, age score).
+//
+//   RecalibrationScheduler scheduler;
+//   scheduler.addChannel("gyro", gyroDrift, 2);          // twice as important
+//   scheduler.addChannel("accel", accelDrift, 1, 30 * 86400);
+//
+//   void loop() {
+//       scheduler.update();
+//       int8_t channel = scheduler.next();
+//       if (channel >= 0) {
+//           Serial.printf("recalibrate %s\n", scheduler.name(channel));
+//       }
+//   }
+class RecalibrationScheduler {
+public:
+    static const uint8_t MAX_CHANNELS = CALIBRATION_MAX_DRIFT_CHANNELS;
+
+    RecalibrationScheduler();
+
+    // name and monitor must outlive the scheduler; returns the channel
+    // index or -1 when full
+    int8_t addChannel(const char* name, DriftMonitor& monitor, uint8_t weight = 1, uint32_t maxAgeSeconds = 0);
+
+    // Adds the time since the previous update to every monitor's
+    // operating time; call from loop()
+    void update();
+    void update(uint32_t nowMs);
+
+    uint8_t channelCount() const { return _count; }
+    const char* name(uint8_t channel) const { return channel < _count ? _channels[channel].name : nullptr; }
+    DriftMonitor* monitor(uint8_t channel) { return channel < _count ? _channels[channel].monitor : nullptr; }
+    int8_t find(const char* name) const;
+
+    bool isDue(uint8_t channel) const;
+    // 0 when neither drift nor age is known; due channels score at least
+    // their weight
+    float priority(uint8_t channel) const;
+    uint8_t dueCount() const;
+    // Highest-priority due channel, or -1 if nothing needs attention
+    int8_t next() const;
+    // Resets the channel's monitor after it has been recalibrated
+    void markRecalibrated(uint8_t channel);
+
+    // One line per channel: name, checks, bias, noise, age, priority
+    void printReport(Print& output) const;
+
+private:
+    struct Channel {
+        const char* name;
+        DriftMonitor* monitor;
+        uint8_t weight;
+        uint32_t maxAgeSeconds;
+    };
+
+    float ageScore(const Channel& channel) const;
+
+    Channel _channels[MAX_CHANNELS];
+    uint8_t _count;
+    bool _started;
+    uint32_t _lastMs;
+    uint32_t _pendingMs;
+};
+
+#endif
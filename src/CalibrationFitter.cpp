@@ -0,0 +1,229 @@
+#include "CalibrationFitter.h"
+
+bool solveLinearSystem(double* a, double* b, uint8_t n) {
+    // Pivots this much smaller than the largest entry are treated as zero
+    double largest = 0.0;
+    for (uint16_t i = 0; i < (uint16_t)n * n; i++) {
+        if (fabs(a[i]) > largest) largest = fabs(a[i]);
+    }
+    const double tolerance = largest * 1e-12;
+    if (largest == 0.0) {
+        return false;
+    }
+
+    for (uint8_t col = 0; col < n; col++) {
+        uint8_t pivot = col;
+        for (uint8_t row = col + 1; row < n; row++) {
+            if (fabs(a[row * n + col]) > fabs(a[pivot * n + col])) {
+                pivot = row;
+            }
+        }
+        if (fabs(a[pivot * n + col]) <= tolerance) {
+            return false;
+        }
+        if (pivot != col) {
+            for (uint8_t k = 0; k < n; k++) {
+                double t = a[col * n + k];
+                a[col * n + k] = a[pivot * n + k];
+                a[pivot * n + k] = t;
+            }
+            double t = b[col];
+            b[col] = b[pivot];
+            b[pivot] = t;
+        }
+        for (uint8_t row = col + 1; row < n; row++) {
+            double factor = a[row * n + col] / a[col * n + col];
+            for (uint8_t k = col; k < n; k++) {
+                a[row * n + k] -= factor * a[col * n + k];
+            }
+            b[row] -= factor * b[col];
+        }
+    }
+
+    for (int8_t row = n - 1; row >= 0; row--) {
+        double sum = b[row];
+        for (uint8_t k = row + 1; k < n; k++) {
+            sum -= a[row * n + k] * b[k];
+        }
+        b[row] = sum / a[row * n + row];
+    }
+    return true;
+}
+
+CalibrationFitter::CalibrationFitter(uint8_t degree, float rawMin, float rawMax) :
+    _degree(degree > MAX_DEGREE ? MAX_DEGREE : degree),
+    _domainSet(false),
+    _center(0.0),
+    _halfRange(1.0) {
+    setDomain(rawMin, rawMax);
+}
+
+bool CalibrationFitter::setDegree(uint8_t degree) {
+    if (degree > MAX_DEGREE) {
+        return false;
+    }
+    _degree = degree;
+    reset();
+    return true;
+}
+
+void CalibrationFitter::setDomain(float rawMin, float rawMax) {
+    _domainSet = rawMax > rawMin;
+    if (_domainSet) {
+        _center = 0.5 * ((double)rawMin + rawMax);
+        _halfRange = 0.5 * ((double)rawMax - rawMin);
+    }
+    reset();
+}
+
+void CalibrationFitter::reset() {
+    _count = 0;
+    _weight = 0.0;
+    memset(_powerSums, 0, sizeof(_powerSums));
+    memset(_momentSums, 0, sizeof(_momentSums));
+    _referenceSum = 0.0;
+    _referenceSquares = 0.0;
+}
+
+void CalibrationFitter::addPoint(float raw, float reference, float weight) {
+    if (!(weight > 0.0f) || !isfinite(raw) || !isfinite(reference)) {
+        return;
+    }
+    if (_count == 0 && !_domainSet) {
+        // Without a declared range, centre on the first point and assume
+        // the other points lie within the same order of magnitude
+        _center = raw;
+        _halfRange = fabs(raw) > 1.0f ? fabs(raw) : 1.0;
+    }
+
+    double u = ((double)raw - _center) / _halfRange;
+    double y = reference;
+    double term = weight;
+    for (uint8_t k = 0; k <= 2 * _degree; k++) {
+        _powerSums[k] += term;
+        if (k <= _degree) {
+            _momentSums[k] += term * y;
+        }
+        term *= u;
+    }
+    _weight += weight;
+    _referenceSum += weight * y;
+    _referenceSquares += weight * y * y;
+    _count++;
+}
+
+bool CalibrationFitter::solveNormalized(double* a) const {
+    const uint8_t n = _degree + 1;
+    if (_count < n) {
+        return false;
+    }
+
+    double normal[(MAX_DEGREE + 1) * (MAX_DEGREE + 1)];
+    for (uint8_t i = 0; i < n; i++) {
+        for (uint8_t j = 0; j < n; j++) {
+            normal[i * n + j] = _powerSums[i + j];
+        }
+        a[i] = _momentSums[i];
+    }
+    return solveLinearSystem(normal, a, n);
+}
+
+// Rewrites sum p[k] * t^k with t = alpha * s + beta as sum q[j] * s^j
+static void rebasePolynomial(const double* p, uint8_t degree, double alpha, double beta, double* q) {
+    for (uint8_t j = 0; j <= degree; j++) {
+        q[j] = 0.0;
+    }
+    for (uint8_t k = 0; k <= degree; k++) {
+        double binomial = 1.0;
+        for (uint8_t j = 0; j <= k; j++) {
+            // term: C(k, j) * (alpha * s)^j * beta^(k - j)
+            q[j] += p[k] * binomial * pow(alpha, j) * pow(beta, k - j);
+            binomial = binomial * (k - j) / (j + 1);
+        }
+    }
+}
+
+void CalibrationFitter::evaluate(const float* coefficients, double alpha, double beta, FitResult* result) const {
+    const uint8_t n = _degree + 1;
+    double stored[MAX_DEGREE + 1];
+    double a[MAX_DEGREE + 1];
+    for (uint8_t i = 0; i < n; i++) {
+        stored[i] = coefficients[i];
+    }
+    rebasePolynomial(stored, _degree, alpha, beta, a);
+
+    // RSS = sum w*y^2 - 2 a.m + a^T P a, all from the running sums
+    double rss = _referenceSquares;
+    for (uint8_t i = 0; i < n; i++) {
+        rss -= 2.0 * a[i] * _momentSums[i];
+        for (uint8_t j = 0; j < n; j++) {
+            rss += a[i] * a[j] * _powerSums[i + j];
+        }
+    }
+    if (rss < 0.0) {
+        rss = 0.0;  // rounding on near-perfect fits
+    }
+    double mean = _referenceSum / _weight;
+    double total = _referenceSquares - _weight * mean * mean;
+    result->count = _count;
+    result->degree = _degree;
+    result->rss = rss;
+    result->rmse = sqrt(rss / _weight);
+    result->r2 = total > 0.0 ? 1.0 - rss / total : 1.0;
+}
+
+bool CalibrationFitter::solve(float* coefficients, FitResult* result) const {
+    double a[MAX_DEGREE + 1];
+    if (!coefficients || !solveNormalized(a)) {
+        return false;
+    }
+
+    // Expand sum a_k * ((raw - c) / h)^k into powers of raw
+    double expanded[MAX_DEGREE + 1];
+    rebasePolynomial(a, _degree, 1.0 / _halfRange, -_center / _halfRange, expanded);
+    for (uint8_t i = 0; i <= _degree; i++) {
+        coefficients[i] = (float)expanded[i];
+    }
+    if (result) {
+        // raw = h * u + c
+        evaluate(coefficients, _halfRange, _center, result);
+    }
+    return true;
+}
+
+bool CalibrationFitter::fit(CalibrationTransform& transform, FitResult* result) const {
+    if (_degree <= 1) {
+        float coefficients[2];
+        if (!solve(coefficients, result)) {
+            return false;
+        }
+        transform.setLinear(_degree == 1 ? coefficients[1] : 0.0f, coefficients[0]);
+        return true;
+    }
+
+    double a[MAX_DEGREE + 1];
+    if (!solveNormalized(a)) {
+        return false;
+    }
+    // The transform evaluates in u' = (raw - center) * inverseRange with
+    // both rounded to float, so refit the terms to that exact variable
+    const float center = (float)_center;
+    const float inverseRange = (float)(1.0 / _halfRange);
+    const double alpha = 1.0 / (_halfRange * inverseRange);
+    const double beta = -((double)_center - center) / _halfRange;
+    double terms[MAX_DEGREE + 1];
+    rebasePolynomial(a, _degree, alpha, beta, terms);
+
+    float coefficients[MAX_DEGREE + 1];
+    for (uint8_t i = 0; i <= _degree; i++) {
+        coefficients[i] = (float)terms[i];
+    }
+    if (!transform.setPolynomial(coefficients, _degree, center, inverseRange)) {
+        return false;
+    }
+    if (result) {
+        // u' = (h * u + c - center) * inverseRange
+        evaluate(coefficients, _halfRange * inverseRange, ((double)_center - center) * inverseRange, result);
+    }
+    return true;
+}
@@ -0,0 +1,80 @@
+#ifndef CALIBRATION_FITTER_H
+#define CALIBRATION_FITTER_H
+
+#include <Arduino.h>
+#include "CalibrationTransform.h"
+
+// Solves the n x n system a * x = b in place by Gaussian elimination with
+// partial pivoting. a is row-major; the solution is written to b. Returns
+// false if the matrix is singular or badly conditioned.
+bool solveLinearSystem(double* a, double* b, uint8_t n);
+
+// Goodness of fit computed from the running sums, without stored samples
+struct FitResult {
+    uint32_t count;     // points accumulated
+    uint8_t degree;     // polynomial degree fitted
+    double rss;         // residual sum of squares
+    double rmse;        // root mean square residual
+    double r2;          // coefficient of determination (1 = perfect)
+};
+
+// Incremental least-squares polynomial fit of reference = f(raw). Each
+// addPoint() folds the pair into the normal-equation sums, so memory stays
+// O(degree) however many points are taken, and fit() can be called at any
+// time to solve for the current coefficients.
+//
+//   CalibrationFitter fitter(1);
+//   fitter.addPoint(readRaw(), 0.0f);     // repeat for each reference
+//   fitter.addPoint(readRaw(), 100.0f);
+//   CalibrationTransform model;
+//   if (fitter.fit(model)) calib.storeTransform("temp", model);
+//
+// Raw values are shifted and scaled into roughly [-1, 1] before they are
+// summed to keep the normal equations well conditioned. Pass the expected
+// raw range to the constructor, otherwise it is estimated from the first point.
+// fit() keeps that normalization in the stored polynomial, so a narrow raw
+// range far from zero (e.g. 3000..3100 counts) still evaluates accurately
+// in float. The reported residuals are those of the float coefficients
+// actually returned or stored, not of the double solution.
+class CalibrationFitter {
+public:
+    static const uint8_t MAX_DEGREE = CALIBRATION_MAX_POLY_DEGREE;
+
+    explicit CalibrationFitter(uint8_t degree = 1, float rawMin = 0.0f, float rawMax = 0.0f);
+
+    // Clears all points; returns false if degree exceeds MAX_DEGREE
+    bool setDegree(uint8_t degree);
+    uint8_t degree() const { return _degree; }
+    void setDomain(float rawMin, float rawMax);
+    void reset();
+
+    void addPoint(float raw, float reference, float weight = 1.0f);
+    uint32_t count() const { return _count; }
+
+    // Solves for coefficients[0..degree] in raw units (coefficients[i]
+    // multiplies raw^i). Needs at least degree + 1 distinct raw values.
+    // Expanding into raw powers loses precision when the raw range is
+    // narrow and far from zero; the result reports that loss. Prefer fit().
+    bool solve(float* coefficients, FitResult* result = nullptr) const;
+    // Solves and stores the polynomial (linear for degree 1) in transform
+    bool fit(CalibrationTransform& transform, FitResult* result = nullptr) const;
+
+private:
+    // Least-squares coefficients of u = (raw - center) / halfRange
+    bool solveNormalized(double* a) const;
+    // Residuals of coefficients[] as a polynomial in t = alpha * u + beta
+    void evaluate(const float* coefficients, double alpha, double beta, FitResult* result) const;
+
+    uint8_t _degree;
+    bool _domainSet;
+    double _center;
+    double _halfRange;
+    uint32_t _count;
+    double _weight;                         // sum of weights
+    double _powerSums[2 * MAX_DEGREE + 1];  // sum w * u^k
+    double _momentSums[MAX_DEGREE + 1];     // sum w * u^k * y
+    double _referenceSum;                   // sum w * y
+    double _referenceSquares;               // sum w * y^2
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include "CalibrationFixedPoint.h"
+
+FixedPointTransform::FixedPointTransform() {
+    compile(1.0f, 0.0f, FIXED_Q15);
+}
+
+bool FixedPointTransform::compile(const CalibrationTransform& transform, FixedPointFormat format, float outputScale) {
+    switch (transform.type()) {
+        case TRANSFORM_IDENTITY:
+            return compile(1.0f, 0.0f, format, outputScale);
+        case TRANSFORM_LINEAR:
+            return compile(transform.scale(), transform.offset(), format, outputScale);
+        default:
+            return false;
+    }
+}
+
+bool FixedPointTransform::compile(float scale, float offset, FixedPointFormat format, float outputScale) {
+    double m = (double)scale * outputScale;
+    double b = (double)offset * outputScale;
+    if (!isfinite(m) || !isfinite(b)) {
+        return false;
+    }
+
+    // Keep the multiplier and offset below these bounds so product, offset
+    // and rounding term cannot overflow the accumulator for any input:
+    // 2^30 + 2^29 + 2^29 <= 2^31 for Q15 and 2^62 + 2^61 + 2^61 <= 2^63 for Q31
+    const double maxMultiplier = format == FIXED_Q15 ? 32767.0 : 2147483647.0;
+    const double maxOffset = format == FIXED_Q15 ? 536870911.0 : 2305843009213693951.0;
+    const uint8_t maxShift = format == FIXED_Q15 ? 30 : 62;
+
+    // Largest shift, i.e. most fractional bits, that still fits both terms
+    int shift = -1;
+    for (int s = maxShift; s >= 0; s--) {
+        double scaled = ldexp(1.0, s);
+        if (fabs(m) * scaled <= maxMultiplier && fabs(b) * scaled <= maxOffset) {
+            shift = s;
+            break;
+        }
+    }
+    if (shift < 0) {
+        return false;
+    }
+
+    _format = format;
+    _shift = shift;
+    _multiplier = (int32_t)llround(ldexp(m, shift));
+    _offset = llround(ldexp(b, shift));
+    _round = shift > 0 ? (int64_t)1 << (shift - 1) : 0;
+    _scale = scale * outputScale;
+    _floatOffset = offset * outputScale;
+    return true;
+}
+
+void FixedPointTransform::applyBatch(const int16_t* raw, int32_t* out, size_t count) const {
+    if (!raw || !out) {
+        return;
+    }
+    if (_format == FIXED_Q15) {
+        // 16-bit inputs need no clamping, leaving a multiply-add and shift
+        const int32_t multiplier = _multiplier;
+        const int32_t bias = (int32_t)(_offset + _round);
+        const uint8_t shift = _shift;
+        for (size_t i = 0; i < count; i++) {
+            int32_t acc = (raw[i] * multiplier + bias) >> shift;
+            out[i] = acc > INT16_MAX ? INT16_MAX : (acc < INT16_MIN ? INT16_MIN : acc);
+        }
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        out[i] = apply(raw[i]);
+    }
+}
+
+float FixedPointTransform::maxError(int32_t rawMin, int32_t rawMax, uint32_t step) const {
+    if (step == 0) {
+        step = 1;
+    }
+    const double limit = _format == FIXED_Q15 ? INT16_MAX : INT32_MAX;
+    double worst = 0.0;
+    for (int64_t raw = rawMin; raw <= rawMax; raw += step) {
+        double expected = (double)raw * _scale + _floatOffset;
+        // Saturation is intended behaviour, not a precision loss
+        expected = expected > limit ? limit : (expected < -limit - 1 ? -limit - 1 : expected);
+        double error = fabs(apply((int32_t)raw) - expected);
+        if (error > worst) {
+            worst = error;
+        }
+    }
+    return (float)worst;
+}
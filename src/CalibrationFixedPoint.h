@@ -0,0 +1,63 @@
+#ifndef CALIBRATION_FIXED_POINT_H
+#define CALIBRATION_FIXED_POINT_H
+
+#include <Arduino.h>
+#include "CalibrationTransform.h"
+
+// Coefficient formats for FixedPointTransform
+enum FixedPointFormat : uint8_t {
+    FIXED_Q15 = 0,  // 16-bit multiplier, 32-bit accumulator, int16_t output
+    FIXED_Q31 = 1   // 32-bit multiplier, 64-bit accumulator, int32_t output
+};
+
+// Integer-only linear calibration for ISRs and cores without an FPU.
+// A float offset/scale pair is compiled once into a multiplier and shift:
+//
+//   out = saturate((raw * multiplier + offset + round) >> shift)
+//
+// where out is the calibrated value times outputScale (for example 1000
+// to get millivolts from a transform that yields volts). apply() uses no
+// float math and no calls, so it can be inlined into an IRAM_ATTR handler.
+class FixedPointTransform {
+public:
+    FixedPointTransform();
+
+    // Only identity and linear transforms can be compiled; returns false
+    // for other types or when the scale does not fit the format
+    bool compile(const CalibrationTransform& transform, FixedPointFormat format, float outputScale = 1.0f);
+    bool compile(float scale, float offset, FixedPointFormat format, float outputScale = 1.0f);
+
+    FixedPointFormat format() const { return _format; }
+    int32_t multiplier() const { return _multiplier; }
+    uint8_t shift() const { return _shift; }
+
+    inline int32_t apply(int32_t raw) const {
+        if (_format == FIXED_Q15) {
+            // Bounds chosen in compile() keep the 32-bit sum from overflowing
+            raw = raw > INT16_MAX ? INT16_MAX : (raw < INT16_MIN ? INT16_MIN : raw);
+            int32_t acc = raw * _multiplier + (int32_t)_offset + _round;
+            acc >>= _shift;
+            return acc > INT16_MAX ? INT16_MAX : (acc < INT16_MIN ? INT16_MIN : acc);
+        }
+        int64_t acc = (int64_t)raw * _multiplier + _offset + _round;
+        acc >>= _shift;
+        return acc > INT32_MAX ? INT32_MAX : (acc < INT32_MIN ? INT32_MIN : (int32_t)acc);
+    }
+
+    void applyBatch(const int16_t* raw, int32_t* out, size_t count) const;
+
+    // Largest difference, in output units, between apply() and the float
+    // transform it was compiled from over raw values [rawMin, rawMax]
+    float maxError(int32_t rawMin, int32_t rawMax, uint32_t step = 1) const;
+
+private:
+    FixedPointFormat _format;
+    uint8_t _shift;
+    int32_t _multiplier;
+    int64_t _offset;    // offset * outputScale in units of 2^-shift
+    int64_t _round;     // half an output LSB, for round-to-nearest
+    float _scale;       // float coefficients kept for maxError()
+    float _floatOffset;
+};
+
+#endif
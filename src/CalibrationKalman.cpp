@@ -0,0 +1,261 @@
+#include "CalibrationKalman.h"
+
+// Serialized layout: magic, version, states, measurements, then the
+// matrices as row-major floats. Tuning and state use different magics so
+// one can never be loaded as the other.
+static const uint8_t KALMAN_TUNING_MAGIC = 'K';
+static const uint8_t KALMAN_STATE_MAGIC = 'X';
+static const uint8_t KALMAN_VERSION = 1;
+
+static const uint8_t MAX_NX = CALIBRATION_MAX_KALMAN_STATES;
+static const uint8_t MAX_NZ = CALIBRATION_MAX_KALMAN_MEASUREMENTS;
+
+KalmanFilterBase::KalmanFilterBase(uint8_t states, uint8_t measurements, float* storage) :
+    _nx(states),
+    _nz(measurements) {
+    _x = storage;
+    _P = _x + states;
+    _F = _P + states * states;
+    _H = _F + states * states;
+    _Q = _H + measurements * states;
+    _R = _Q + states * states;
+    _y = _R + measurements * measurements;
+}
+
+static void setDiagonal(float* m, uint8_t rows, uint8_t cols, float value) {
+    for (uint8_t r = 0; r < rows; r++) {
+        for (uint8_t c = 0; c < cols; c++) {
+            m[r * cols + c] = r == c ? value : 0.0f;
+        }
+    }
+}
+
+void KalmanFilterBase::reset(float variance) {
+    for (uint8_t i = 0; i < _nx; i++) {
+        _x[i] = 0.0f;
+    }
+    for (uint8_t i = 0; i < _nz; i++) {
+        _y[i] = 0.0f;
+    }
+    setDiagonal(_P, _nx, _nx, variance);
+    setDiagonal(_F, _nx, _nx, 1.0f);
+    setDiagonal(_H, _nz, _nx, 1.0f);
+    setDiagonal(_Q, _nx, _nx, 1e-4f);
+    setDiagonal(_R, _nz, _nz, 1e-2f);
+}
+
+void KalmanFilterBase::setTransition(const float* F) {
+    if (F) memcpy(_F, F, _nx * _nx * sizeof(float));
+}
+
+void KalmanFilterBase::setObservation(const float* H) {
+    if (H) memcpy(_H, H, _nz * _nx * sizeof(float));
+}
+
+void KalmanFilterBase::setProcessNoise(const float* Q) {
+    if (Q) memcpy(_Q, Q, _nx * _nx * sizeof(float));
+}
+
+void KalmanFilterBase::setMeasurementNoise(const float* R) {
+    if (R) memcpy(_R, R, _nz * _nz * sizeof(float));
+}
+
+void KalmanFilterBase::setProcessNoise(float variance) {
+    setDiagonal(_Q, _nx, _nx, variance);
+}
+
+void KalmanFilterBase::setMeasurementNoise(float variance) {
+    setDiagonal(_R, _nz, _nz, variance);
+}
+
+void KalmanFilterBase::setState(const float* x, float variance) {
+    if (x) memcpy(_x, x, _nx * sizeof(float));
+    setDiagonal(_P, _nx, _nx, variance);
+}
+
+void KalmanFilterBase::predict(const float* control) {
+    const uint8_t n = _nx;
+
+    float x[MAX_NX];
+    for (uint8_t r = 0; r < n; r++) {
+        float sum = control ? control[r] : 0.0f;
+        for (uint8_t c = 0; c < n; c++) {
+            sum += _F[r * n + c] * _x[c];
+        }
+        x[r] = sum;
+    }
+    memcpy(_x, x, n * sizeof(float));
+
+    // FP = F P, then P = FP F' + Q; only the upper triangle is computed
+    // and mirrored, which also keeps P exactly symmetric
+    float FP[MAX_NX * MAX_NX];
+    for (uint8_t r = 0; r < n; r++) {
+        for (uint8_t c = 0; c < n; c++) {
+            float sum = 0.0f;
+            for (uint8_t k = 0; k < n; k++) {
+                sum += _F[r * n + k] * _P[k * n + c];
+            }
+            FP[r * n + c] = sum;
+        }
+    }
+    for (uint8_t r = 0; r < n; r++) {
+        for (uint8_t c = r; c < n; c++) {
+            float sum = _Q[r * n + c];
+            for (uint8_t k = 0; k < n; k++) {
+                sum += FP[r * n + k] * _F[c * n + k];
+            }
+            _P[r * n + c] = sum;
+            _P[c * n + r] = sum;
+        }
+    }
+}
+
+// In-place Cholesky factorization S = L L' of an m x m matrix, leaving L
+// in the lower triangle; false if S is not positive definite
+static bool choleskyFactor(float* S, uint8_t m) {
+    for (uint8_t j = 0; j < m; j++) {
+        float d = S[j * m + j];
+        for (uint8_t k = 0; k < j; k++) {
+            d -= S[j * m + k] * S[j * m + k];
+        }
+        if (!(d > 0.0f)) {
+            return false;
+        }
+        d = sqrtf(d);
+        S[j * m + j] = d;
+        for (uint8_t i = j + 1; i < m; i++) {
+            float sum = S[i * m + j];
+            for (uint8_t k = 0; k < j; k++) {
+                sum -= S[i * m + k] * S[j * m + k];
+            }
+            S[i * m + j] = sum / d;
+        }
+    }
+    return true;
+}
+
+// Solves L L' v = b in place
+static void choleskySolve(const float* L, uint8_t m, float* b) {
+    for (uint8_t i = 0; i < m; i++) {
+        float sum = b[i];
+        for (uint8_t k = 0; k < i; k++) {
+            sum -= L[i * m + k] * b[k];
+        }
+        b[i] = sum / L[i * m + i];
+    }
+    for (int8_t i = m - 1; i >= 0; i--) {
+        float sum = b[i];
+        for (uint8_t k = i + 1; k < m; k++) {
+            sum -= L[k * m + i] * b[k];
+        }
+        b[i] = sum / L[i * m + i];
+    }
+}
+
+bool KalmanFilterBase::update(const float* z) {
+    if (!z) {
+        return false;
+    }
+    const uint8_t n = _nx;
+    const uint8_t m = _nz;
+
+    // PHt = P H' (n x m), S = H PHt + R (m x m)
+    float PHt[MAX_NX * MAX_NZ];
+    for (uint8_t r = 0; r < n; r++) {
+        for (uint8_t c = 0; c < m; c++) {
+            float sum = 0.0f;
+            for (uint8_t k = 0; k < n; k++) {
+                sum += _P[r * n + k] * _H[c * n + k];
+            }
+            PHt[r * m + c] = sum;
+        }
+    }
+    float S[MAX_NZ * MAX_NZ];
+    for (uint8_t r = 0; r < m; r++) {
+        for (uint8_t c = 0; c < m; c++) {
+            float sum = _R[r * m + c];
+            for (uint8_t k = 0; k < n; k++) {
+                sum += _H[r * n + k] * PHt[k * m + c];
+            }
+            S[r * m + c] = sum;
+        }
+    }
+    if (!choleskyFactor(S, m)) {
+        return false;
+    }
+
+    for (uint8_t r = 0; r < m; r++) {
+        float sum = z[r];
+        for (uint8_t k = 0; k < n; k++) {
+            sum -= _H[r * n + k] * _x[k];
+        }
+        _y[r] = sum;
+    }
+
+    // S is symmetric, so row i of K = P H' S^-1 solves S k = row i of PHt
+    float K[MAX_NX * MAX_NZ];
+    memcpy(K, PHt, n * m * sizeof(float));
+    for (uint8_t r = 0; r < n; r++) {
+        choleskySolve(S, m, &K[r * m]);
+    }
+
+    for (uint8_t r = 0; r < n; r++) {
+        for (uint8_t c = 0; c < m; c++) {
+            _x[r] += K[r * m + c] * _y[c];
+        }
+    }
+    // P -= K (P H')', mirrored from the upper triangle
+    for (uint8_t r = 0; r < n; r++) {
+        for (uint8_t c = r; c < n; c++) {
+            float sum = _P[r * n + c];
+            for (uint8_t k = 0; k < m; k++) {
+                sum -= K[r * m + k] * PHt[c * m + k];
+            }
+            _P[r * n + c] = sum;
+            _P[c * n + r] = sum;
+        }
+    }
+    return true;
+}
+
+static size_t writeMatrices(uint8_t* buffer, size_t size, uint8_t magic, uint8_t nx, uint8_t nz,
+                            const float* a, size_t countA, const float* b, size_t countB) {
+    const size_t total = 4 + (countA + countB) * sizeof(float);
+    if (!buffer || size < total) {
+        return 0;
+    }
+    buffer[0] = magic;
+    buffer[1] = KALMAN_VERSION;
+    buffer[2] = nx;
+    buffer[3] = nz;
+    memcpy(buffer + 4, a, countA * sizeof(float));
+    memcpy(buffer + 4 + countA * sizeof(float), b, countB * sizeof(float));
+    return total;
+}
+
+static bool readMatrices(const uint8_t* buffer, size_t size, uint8_t magic, uint8_t nx, uint8_t nz,
+                         float* a, size_t countA, float* b, size_t countB) {
+    if (!buffer || size != 4 + (countA + countB) * sizeof(float) ||
+        buffer[0] != magic || buffer[1] != KALMAN_VERSION || buffer[2] != nx || buffer[3] != nz) {
+        return false;
+    }
+    memcpy(a, buffer + 4, countA * sizeof(float));
+    memcpy(b, buffer + 4 + countA * sizeof(float), countB * sizeof(float));
+    return true;
+}
+
+size_t KalmanFilterBase::serializeTuning(uint8_t* buffer, size_t size) const {
+    return writeMatrices(buffer, size, KALMAN_TUNING_MAGIC, _nx, _nz, _Q, _nx * _nx, _R, _nz * _nz);
+}
+
+bool KalmanFilterBase::deserializeTuning(const uint8_t* buffer, size_t size) {
+    return readMatrices(buffer, size, KALMAN_TUNING_MAGIC, _nx, _nz, _Q, _nx * _nx, _R, _nz * _nz);
+}
+
+size_t KalmanFilterBase::serializeState(uint8_t* buffer, size_t size) const {
+    return writeMatrices(buffer, size, KALMAN_STATE_MAGIC, _nx, _nz, _x, _nx, _P, _nx * _nx);
+}
+
+bool KalmanFilterBase::deserializeState(const uint8_t* buffer, size_t size) {
+    return readMatrices(buffer, size, KALMAN_STATE_MAGIC, _nx, _nz, _x, _nx, _P, _nx * _nx);
+}
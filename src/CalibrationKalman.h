@@ -0,0 +1,123 @@
+#ifndef CALIBRATION_KALMAN_H
+#define CALIBRATION_KALMAN_H
+
+#include <Arduino.h>
+
+// Largest state and measurement vectors a KalmanFilter may use; they bound
+// the stack scratch of update() and the size of the stored blobs
+#ifndef CALIBRATION_MAX_KALMAN_STATES
+#define CALIBRATION_MAX_KALMAN_STATES 6
+#endif
+
+#ifndef CALIBRATION_MAX_KALMAN_MEASUREMENTS
+#define CALIBRATION_MAX_KALMAN_MEASUREMENTS 3
+#endif
+
+// Linear Kalman filter over caller-owned storage. Matrices are row-major:
+// F is states x states, H measurements x states, Q states x states and
+// R measurements x measurements.
+//
+//   predict(u):  x = F x + u            P = F P F' + Q
+//   update(z):   y = z - H x            S = H P H' + R
+//                K = P H' S^-1          x += K y,  P -= K H P
+//
+// The control input u is added to the state directly; pass B u when the
+// model has a control matrix. The noise matrices Q and R are the tuning and
+// can be stored as calibration data; x and P are the state and can be
+// checkpointed for a warm start after reboot. F and H describe the model and
+// stay in code.
+//
+// Use KalmanFilter<NX, NZ> below, which supplies the storage.
+class KalmanFilterBase {
+public:
+    static const size_t MAX_TUNING_SIZE = 4 + sizeof(float) *
+        (CALIBRATION_MAX_KALMAN_STATES * CALIBRATION_MAX_KALMAN_STATES +
+         CALIBRATION_MAX_KALMAN_MEASUREMENTS * CALIBRATION_MAX_KALMAN_MEASUREMENTS);
+    static const size_t MAX_STATE_SIZE = 4 + sizeof(float) *
+        (CALIBRATION_MAX_KALMAN_STATES + CALIBRATION_MAX_KALMAN_STATES * CALIBRATION_MAX_KALMAN_STATES);
+
+    uint8_t states() const { return _nx; }
+    uint8_t measurements() const { return _nz; }
+
+    // Identity F, ones on the diagonal of H, zero state and diagonal P, Q, R
+    void reset(float variance = 1.0f);
+
+    void setTransition(const float* F);
+    void setObservation(const float* H);
+    void setProcessNoise(const float* Q);
+    void setMeasurementNoise(const float* R);
+    // Diagonal noise, the same variance on every axis
+    void setProcessNoise(float variance);
+    void setMeasurementNoise(float variance);
+    // Sets the state with an uncorrelated covariance; a null x keeps the
+    // current state and only resets P
+    void setState(const float* x, float variance);
+
+    void predict(const float* control = nullptr);
+    // Returns false and leaves the state alone when H P H' + R is not
+    // positive definite, usually a sign of an untuned R
+    bool update(const float* z);
+
+    const float* state() const { return _x; }
+    float state(uint8_t i) const { return i < _nx ? _x[i] : 0.0f; }
+    float variance(uint8_t i) const { return i < _nx ? _P[i * _nx + i] : 0.0f; }
+    // z - H x from the last update, before the correction
+    float innovation(uint8_t i) const { return i < _nz ? _y[i] : 0.0f; }
+
+    // Q and R; rejected when the dimensions differ
+    size_t serializeTuning(uint8_t* buffer, size_t size) const;
+    bool deserializeTuning(const uint8_t* buffer, size_t size);
+    // x and P
+    size_t serializeState(uint8_t* buffer, size_t size) const;
+    bool deserializeState(const uint8_t* buffer, size_t size);
+
+protected:
+    KalmanFilterBase(uint8_t states, uint8_t measurements, float* storage);
+
+private:
+    KalmanFilterBase(const KalmanFilterBase&);
+    KalmanFilterBase& operator=(const KalmanFilterBase&);
+
+    uint8_t _nx;
+    uint8_t _nz;
+    float* _x;
+    float* _P;
+    float* _F;
+    float* _H;
+    float* _Q;
+    float* _R;
+    float* _y;
+};
+
+// Dimensions are fixed at compile time and all storage lives in the
+// object, so nothing is allocated. A tilt filter tracking one angle and
+// the gyro bias, corrected by the accelerometer angle:
+//
+//   KalmanFilter<2, 1> roll;
+//   const float dt = 0.01f;
+//   const float F[] = {1.0f, -dt, 0.0f, 1.0f};
+//   const float H[] = {1.0f, 0.0f};
+//   roll.setTransition(F);
+//   roll.setObservation(H);
+//   calib.loadKalmanTuning("roll_tune", roll);
+//
+//   float u[] = {gyroX * dt, 0.0f};
+//   roll.predict(u);
+//   roll.update(&accelRoll);
+template <uint8_t NX, uint8_t NZ>
+class KalmanFilter : public KalmanFilterBase {
+    static_assert(NX > 0 && NX <= CALIBRATION_MAX_KALMAN_STATES, "KalmanFilter: too many states");
+    static_assert(NZ > 0 && NZ <= CALIBRATION_MAX_KALMAN_MEASUREMENTS, "KalmanFilter: too many measurements");
+
+public:
+    static const size_t TUNING_SIZE = 4 + sizeof(float) * (NX * NX + NZ * NZ);
+    static const size_t STATE_SIZE = 4 + sizeof(float) * (NX + NX * NX);
+
+    KalmanFilter() : KalmanFilterBase(NX, NZ, _storage) { reset(); }
+
+private:
+    // x, P, F, H, Q, R, y
+    float _storage[NX + 3 * NX * NX + NZ * NX + NZ * NZ + NZ];
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include "CalibrationLUT.h"
+
+#if defined(ESP32)
+#include <esp_heap_caps.h>
+#endif
+
+CalibrationLUT::CalibrationLUT() :
+    _source(nullptr),
+    _revision(0),
+    _table(nullptr),
+    _size(0),
+    _bits(0),
+    _memory(LUT_INTERNAL),
+    _psram(false) {
+}
+
+CalibrationLUT::~CalibrationLUT() {
+    release();
+}
+
+void CalibrationLUT::release() {
+    if (_table) {
+        free(_table);   // heap_caps_malloc memory is also released with free()
+    }
+    _table = nullptr;
+    _size = 0;
+    _psram = false;
+}
+
+bool CalibrationLUT::allocate(size_t size, LUTMemory memory) {
+    if (_table && _size == size && _memory == memory) {
+        return true;
+    }
+    release();
+
+    size_t bytes = size * sizeof(float);
+#if defined(ESP32)
+    if (memory == LUT_PSRAM) {
+        _table = (float*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        _psram = _table != nullptr;
+    }
+    if (!_table) {
+        _table = (float*)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+#else
+    _table = (float*)malloc(bytes);
+#endif
+    if (!_table) {
+        return false;
+    }
+    _size = size;
+    _memory = memory;
+    return true;
+}
+
+bool CalibrationLUT::build(const CalibrationTransform& transform, uint8_t bits, LUTMemory memory) {
+    if (bits == 0 || bits > MAX_BITS) {
+        return false;
+    }
+    if (!allocate((size_t)1 << bits, memory)) {
+        _source = nullptr;
+        return false;
+    }
+    _source = &transform;
+    _bits = bits;
+    fill();
+    return true;
+}
+
+bool CalibrationLUT::refresh() {
+    if (!_source) {
+        return false;
+    }
+    if (!_table && !allocate((size_t)1 << _bits, _memory)) {
+        return false;
+    }
+    if (_revision != _source->revision()) {
+        fill();
+    }
+    return true;
+}
+
+void CalibrationLUT::fill() {
+    // Evaluate in blocks through applyBatch so linear and polynomial
+    // transforms use the vectorized kernels
+    const size_t BLOCK = 64;
+    float ramp[BLOCK];
+    for (size_t start = 0; start < _size; start += BLOCK) {
+        size_t length = _size - start < BLOCK ? _size - start : BLOCK;
+        for (size_t i = 0; i < length; i++) {
+            ramp[i] = (float)(start + i);
+        }
+        _source->applyBatch(ramp, _table + start, length);
+    }
+    _revision = _source->revision();
+}
+
+void CalibrationLUT::applyBatch(const uint16_t* raw, float* out, size_t count) {
+    if (!raw || !out) {
+        return;
+    }
+    if (isStale()) {
+        refresh();
+    }
+    if (!_table) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        out[i] = lookup(raw[i]);
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef CALIBRATION_LUT_H
+#define CALIBRATION_LUT_H
+
+#include <Arduino.h>
+#include "CalibrationTransform.h"
+
+// Where CalibrationLUT allocates its table
+enum LUTMemory : uint8_t {
+    LUT_INTERNAL = 0,   // internal RAM, fastest lookups
+    LUT_PSRAM = 1       // external PSRAM if present, otherwise internal RAM
+};
+
+// Full-range lookup table for a low-resolution channel. The bound transform
+// is evaluated once for every raw value in [0, 2^bits), after which a
+// calibrated sample costs one indexed load. A 12-bit float table takes 16KB.
+//
+//   CalibrationTransform pot;
+//   calib.loadTransform("pot", pot);
+//   CalibrationLUT lut;
+//   lut.build(pot, 12);
+//   float percent = lut.apply(analogRead(34));
+//
+// The table keeps a pointer to the transform and rebuilds itself the next
+// time apply() runs after the transform's coefficients change. The
+// transform must outlive the table.
+class CalibrationLUT {
+public:
+    static const uint8_t MAX_BITS = 16;
+
+    CalibrationLUT();
+    ~CalibrationLUT();
+
+    bool build(const CalibrationTransform& transform, uint8_t bits = 12, LUTMemory memory = LUT_INTERNAL);
+    void release();
+
+    // Rebuilds the table if the bound transform changed; returns false if
+    // nothing is bound or the rebuild could not allocate
+    bool refresh();
+    bool isStale() const { return _source && _revision != _source->revision(); }
+
+    bool isValid() const { return _table != nullptr; }
+    uint8_t bits() const { return _bits; }
+    size_t size() const { return _size; }
+    size_t memoryUsage() const { return _size * sizeof(float); }
+    bool inPsram() const { return _psram; }
+
+    // Bare table read for ISRs: no staleness check and no rebuild. Raw
+    // values past the end clamp to the last entry.
+    inline float lookup(uint32_t raw) const {
+        return _table[raw < _size ? raw : _size - 1];
+    }
+
+    inline float apply(uint32_t raw) {
+        if (isStale()) {
+            refresh();
+        }
+        return _table ? lookup(raw) : 0.0f;
+    }
+
+    void applyBatch(const uint16_t* raw, float* out, size_t count);
+
+private:
+    CalibrationLUT(const CalibrationLUT&);
+    CalibrationLUT& operator=(const CalibrationLUT&);
+
+    bool allocate(size_t size, LUTMemory memory);
+    void fill();
+
+    const CalibrationTransform* _source;
+    uint32_t _revision;
+    float* _table;
+    size_t _size;
+    uint8_t _bits;
+    LUTMemory _memory;
+    bool _psram;
+};
+
+#endif
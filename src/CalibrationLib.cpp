@@ -1,14 +1,60 @@
 #include "CalibrationLib.h"
 #include <stdarg.h>
+#include <mbedtls/base64.h>
+
+// Log sites above CALIBRATION_LOG_LEVEL compile to nothing, so neither the
+// format string nor the arguments reach the binary. Enabled sites check the
+// runtime level inline before paying for the call. In deferred mode the
+// arguments are only copied into the ring buffer.
+#define CAL_LOG(level, format, ...) \
+    do { \
+        if ((level) <= CALIBRATION_LOG_LEVEL && (level) <= _debugLevel) { \
+            if (_logMode.load(std::memory_order_acquire) == LOG_DEFERRED) { \
+                _logBuffer.record((level), PSTR(format), ##__VA_ARGS__); \
+            } else { \
+                logValues((level), PSTR(format), ##__VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+// Instruments the enclosing scope: records it into the operation's latency
+// histogram and reports it to the trace hook, as configured at build time.
+#define CAL_CONCAT_(a, b) a##b
+#define CAL_CONCAT(a, b) CAL_CONCAT_(a, b)
+
+#if CALIBRATION_ENABLE_PROFILING
+#define CAL_PROFILE(op) LatencyScope CAL_CONCAT(_latencyScope, __LINE__)(_latency[op])
+#else
+#define CAL_PROFILE(op)
+#endif
+
+#if CALIBRATION_ENABLE_TRACING
+#define CAL_TRACE(op, detail) TraceScope CAL_CONCAT(_traceScope, __LINE__)(_traceHook, _traceContext, op, detail)
+#else
+#define CAL_TRACE(op, detail)
+#endif
+
+#define CAL_SCOPE(op, detail) CAL_PROFILE(op); CAL_TRACE(op, detail)
+
+// Bumps a metrics counter; compiled out with CALIBRATION_ENABLE_METRICS=0
+#if CALIBRATION_ENABLE_METRICS
+#define CAL_COUNT(counter, n) _metrics.counter.fetch_add((n), std::memory_order_relaxed)
+#else
+#define CAL_COUNT(counter, n)
+#endif
 
 // Constructor with initialization
 CalibrationLib::CalibrationLib() : 
     _initialized(false),
     _debugLevel(DEBUG_NONE),
     _debugOutput(&Serial),
+    _logMode(LOG_IMMEDIATE),
     _lastError(CAL_OK),
     _encryptionEnabled(false),
-    _batchMode(false) {
+    _batchMode(false),
+    _traceHook(nullptr),
+    _traceContext(nullptr) {
+    _namespace[0] = '\0';
 }
 
 // Debug and logging methods
@@ -20,6 +66,30 @@ void CalibrationLib::setDebugOutput(Print* output) {
     _debugOutput = output ? output : &Serial;
 }
 
+bool CalibrationLib::setLogMode(LogMode mode, size_t bufferEntries) {
+    if (mode == LOG_DEFERRED && !_logBuffer.isAllocated() && !_logBuffer.allocate(bufferEntries)) {
+        setError(CAL_MEMORY_ERROR);
+        return false;
+    }
+    // Publish the mode after allocating and before flushing. The ring is
+    // kept when switching back: another task may still be inside CAL_LOG
+    // with the old mode, so it is only freed with the instance.
+    _logMode.store(mode, std::memory_order_release);
+    if (mode == LOG_IMMEDIATE) {
+        flushLog();
+    }
+    return true;
+}
+
+size_t CalibrationLib::flushLog(size_t maxEntries) {
+    if (!_debugOutput) return 0;
+    return _logBuffer.drain(*_debugOutput, maxEntries);
+}
+
+uint32_t CalibrationLib::getDroppedLogCount() const {
+    return _logBuffer.dropped();
+}
+
 CalibrationError CalibrationLib::getLastError() const {
     return _lastError;
 }
@@ -33,6 +103,7 @@ const char* CalibrationLib::getErrorString(CalibrationError error) const {
         case CAL_READ_ERROR: return "Read error";
         case CAL_MEMORY_ERROR: return "Memory error";
         case CAL_ENCRYPTION_ERROR: return "Encryption error";
+        case CAL_NOT_FOUND: return "Key not found";
         default: return "Unknown error";
     }
 }
@@ -42,7 +113,7 @@ void CalibrationLib::log(DebugLevel level, const char* format, ...) {
         char buffer[256];
         va_list args;
         va_start(args, format);
-        vsnprintf(buffer, sizeof(buffer), format, args);
+        vsnprintf_P(buffer, sizeof(buffer), format, args);
         va_end(args);
         
         _debugOutput->println(buffer);
@@ -51,9 +122,16 @@ void CalibrationLib::log(DebugLevel level, const char* format, ...) {
 
 void CalibrationLib::setError(CalibrationError error) {
     _lastError = error;
+    reportError(error);
+}
+
+// Counts and logs an error without touching the shared _lastError
+CalibrationError CalibrationLib::reportError(CalibrationError error) {
     if (error != CAL_OK) {
-        log(DEBUG_ERROR, "Error: %s", getErrorString(error));
+        CAL_COUNT(errors[-error], 1);
+        CAL_LOG(DEBUG_ERROR, "Error: %s", getErrorString(error));
     }
+    return error;
 }
 
 // Validation methods
@@ -84,17 +162,18 @@ bool CalibrationLib::batchBegin() {
         return false;
     }
     _batchMode = true;
-    log(DEBUG_INFO, "Batch operation started");
+    CAL_LOG(DEBUG_INFO, "Batch operation started");
     return true;
 }
 
 bool CalibrationLib::batchCommit() {
+    CAL_SCOPE(CAL_OP_BATCH_COMMIT, nullptr);
     if (!_initialized || !_batchMode) {
         setError(CAL_NOT_INITIALIZED);
         return false;
     }
     _batchMode = false;
-    log(DEBUG_INFO, "Batch operation committed");
+    CAL_LOG(DEBUG_INFO, "Batch operation committed");
     return true;
 }
 
@@ -104,10 +183,58 @@ bool CalibrationLib::batchRollback() {
         return false;
     }
     _batchMode = false;
-    log(DEBUG_INFO, "Batch operation rolled back");
+    CAL_LOG(DEBUG_INFO, "Batch operation rolled back");
     return true;
 }
 
+// Latency instrumentation
+bool CalibrationLib::getLatencyHistogram(CalibrationOp op, LatencyHistogram& histogram) const {
+#if CALIBRATION_ENABLE_PROFILING
+    if (op < 0 || op >= CAL_OP_COUNT) return false;
+    histogram = _latency[op];
+    return true;
+#else
+    return false;
+#endif
+}
+
+void CalibrationLib::printLatencyStats(Print& output) const {
+#if CALIBRATION_ENABLE_PROFILING
+    for (int op = 0; op < CAL_OP_COUNT; op++) {
+        _latency[op].printTo(output, getOperationName((CalibrationOp)op));
+    }
+#else
+    output.println("Latency profiling disabled (CALIBRATION_ENABLE_PROFILING=0)");
+#endif
+}
+
+void CalibrationLib::resetLatencyStats() {
+#if CALIBRATION_ENABLE_PROFILING
+    for (int op = 0; op < CAL_OP_COUNT; op++) {
+        _latency[op].reset();
+    }
+#endif
+}
+
+// Tracing
+void CalibrationLib::setTraceHook(CalibrationTraceHook hook, void* context) {
+    _traceHook = hook;
+    _traceContext = context;
+}
+
+// Operation counters
+const CalibrationMetrics& CalibrationLib::getMetrics() const {
+    return _metrics;
+}
+
+void CalibrationLib::resetMetrics() {
+    _metrics.reset();
+}
+
+void CalibrationLib::writeMetrics(Print& output, MetricsFormat format) const {
+    _metrics.writeTo(output, format, _namespace);
+}
+
 // Memory management
 size_t CalibrationLib::getFreeSpace() const {
     return _initialized ? _preferences.freeEntries() : 0;
@@ -119,6 +246,7 @@ size_t CalibrationLib::getUsedSpace() const {
 
 // Modified existing methods to use new error handling
 bool CalibrationLib::begin(const char* namespace_name) {
+    CAL_SCOPE(CAL_OP_BEGIN, namespace_name);
     if (!namespace_name) {
         setError(CAL_INVALID_PARAM);
         return false;
@@ -134,10 +262,24 @@ bool CalibrationLib::begin(const char* namespace_name) {
         return false;
     }
     
-    log(DEBUG_INFO, "Initialized with namespace: %s", namespace_name);
+    strncpy(_namespace, namespace_name, sizeof(_namespace) - 1);
+    _namespace[sizeof(_namespace) - 1] = '\0';
+    CAL_LOG(DEBUG_INFO, "Initialized with namespace: %s", LogText{namespace_name});
     return true;
 }
 
+CalibrationError CalibrationLib::recordWrite(size_t written) {
+  CAL_COUNT(nvsWrites, 1);
+  CAL_COUNT(bytesWritten, written);
+  return written > 0 ? CAL_OK : reportError(CAL_WRITE_ERROR);
+}
+
+CalibrationError CalibrationLib::checkAccess(const char* key) {
+  if (!_initialized) return reportError(CAL_NOT_INITIALIZED);
+  if (!key || !*key) return reportError(CAL_INVALID_PARAM);
+  return CAL_OK;
+}
+
 void CalibrationLib::end() {
   if (_initialized) {
     _preferences.end();
@@ -145,72 +287,389 @@ void CalibrationLib::end() {
   }
 }
 
+CalibrationError CalibrationLib::trySetCalibrationValue(const char* key, int value) {
+  CAL_SCOPE(CAL_OP_SET, key);
+  CalibrationError error = checkAccess(key);
+  if (error != CAL_OK) return error;
+  return recordWrite(_preferences.putInt(key, value));
+}
+
+CalibrationError CalibrationLib::trySetCalibrationValue(const char* key, float value) {
+  CAL_SCOPE(CAL_OP_SET, key);
+  CalibrationError error = checkAccess(key);
+  if (error != CAL_OK) return error;
+  return recordWrite(_preferences.putFloat(key, value));
+}
+
+CalibrationError CalibrationLib::trySetCalibrationValue(const char* key, const char* value) {
+  CAL_SCOPE(CAL_OP_SET, key);
+  CalibrationError error = checkAccess(key);
+  if (error != CAL_OK) return error;
+  if (!value) return reportError(CAL_INVALID_PARAM);
+  return recordWrite(_preferences.putString(key, value));
+}
+
+CalibrationResult<int> CalibrationLib::tryGetCalibrationInt(const char* key) {
+  CAL_SCOPE(CAL_OP_GET, key);
+  CalibrationResult<int> result = {0, checkAccess(key)};
+  if (result.error != CAL_OK) return result;
+  CAL_COUNT(nvsReads, 1);
+  if (!_preferences.isKey(key)) {
+    result.error = CAL_NOT_FOUND;
+    return result;
+  }
+  result.value = _preferences.getInt(key, 0);
+  return result;
+}
+
+CalibrationResult<float> CalibrationLib::tryGetCalibrationFloat(const char* key) {
+  CAL_SCOPE(CAL_OP_GET, key);
+  CalibrationResult<float> result = {0.0f, checkAccess(key)};
+  if (result.error != CAL_OK) return result;
+  CAL_COUNT(nvsReads, 1);
+  if (!_preferences.isKey(key)) {
+    result.error = CAL_NOT_FOUND;
+    return result;
+  }
+  result.value = _preferences.getFloat(key, 0.0f);
+  return result;
+}
+
+CalibrationResult<String> CalibrationLib::tryGetCalibrationString(const char* key) {
+  CAL_SCOPE(CAL_OP_GET, key);
+  CalibrationResult<String> result = {String(), checkAccess(key)};
+  if (result.error != CAL_OK) return result;
+  CAL_COUNT(nvsReads, 1);
+  if (!_preferences.isKey(key)) {
+    result.error = CAL_NOT_FOUND;
+    return result;
+  }
+  result.value = _preferences.getString(key, "");
+  return result;
+}
+
+CalibrationError CalibrationLib::storeBlob(const char* key, const void* data, size_t size) {
+  CAL_SCOPE(CAL_OP_SET, key);
+  CalibrationError error = checkAccess(key);
+  if (error != CAL_OK) return error;
+  if (!validateValue(key, data, size)) return reportError(CAL_INVALID_PARAM);
+  return recordWrite(_preferences.putBytes(key, data, size));
+}
+
+CalibrationResult<size_t> CalibrationLib::loadBlob(const char* key, void* buffer, size_t size) {
+  CAL_SCOPE(CAL_OP_GET, key);
+  CalibrationResult<size_t> result = {0, checkAccess(key)};
+  if (result.error != CAL_OK) return result;
+  if (!buffer) {
+    result.error = reportError(CAL_INVALID_PARAM);
+    return result;
+  }
+  CAL_COUNT(nvsReads, 1);
+  size_t length = _preferences.getBytesLength(key);
+  if (length == 0) {
+    result.error = CAL_NOT_FOUND;
+    return result;
+  }
+  if (length > size) {
+    result.error = reportError(CAL_MEMORY_ERROR);
+    return result;
+  }
+  result.value = _preferences.getBytes(key, buffer, size);
+  if (result.value != length) {
+    result.error = reportError(CAL_READ_ERROR);
+  }
+  return result;
+}
+
+CalibrationError CalibrationLib::storeTransform(const char* channel, const CalibrationTransform& transform) {
+  uint8_t buffer[CalibrationTransform::MAX_SERIALIZED_SIZE];
+  size_t size = transform.serialize(buffer, sizeof(buffer));
+  if (size == 0) return reportError(CAL_INVALID_PARAM);
+  return storeBlob(channel, buffer, size);
+}
+
+CalibrationError CalibrationLib::loadTransform(const char* channel, CalibrationTransform& transform) {
+  uint8_t buffer[CalibrationTransform::MAX_SERIALIZED_SIZE];
+  CalibrationResult<size_t> result = loadBlob(channel, buffer, sizeof(buffer));
+  if (!result) return result.error;
+  if (!transform.deserialize(buffer, result.value)) return reportError(CAL_READ_ERROR);
+  return CAL_OK;
+}
+
+CalibrationError CalibrationLib::storeAxisCalibration(const char* key, const AxisCalibration& calibration) {
+  uint8_t buffer[AxisCalibration::SERIALIZED_SIZE];
+  size_t size = calibration.serialize(buffer, sizeof(buffer));
+  if (size == 0) return reportError(CAL_INVALID_PARAM);
+  return storeBlob(key, buffer, size);
+}
+
+CalibrationError CalibrationLib::loadAxisCalibration(const char* key, AxisCalibration& calibration) {
+  uint8_t buffer[AxisCalibration::SERIALIZED_SIZE];
+  CalibrationResult<size_t> result = loadBlob(key, buffer, sizeof(buffer));
+  if (!result) return result.error;
+  if (!calibration.deserialize(buffer, result.value)) return reportError(CAL_READ_ERROR);
+  return CAL_OK;
+}
+
+CalibrationError CalibrationLib::storeThermalCalibration(const char* key, const ThermalCalibration& calibration) {
+  uint8_t buffer[ThermalCalibration::MAX_SERIALIZED_SIZE];
+  size_t size = calibration.serialize(buffer, sizeof(buffer));
+  if (size == 0) return reportError(CAL_INVALID_PARAM);
+  return storeBlob(key, buffer, size);
+}
+
+CalibrationError CalibrationLib::loadThermalCalibration(const char* key, ThermalCalibration& calibration) {
+  uint8_t buffer[ThermalCalibration::MAX_SERIALIZED_SIZE];
+  CalibrationResult<size_t> result = loadBlob(key, buffer, sizeof(buffer));
+  if (!result) return result.error;
+  if (!calibration.deserialize(buffer, result.value)) return reportError(CAL_READ_ERROR);
+  return CAL_OK;
+}
+
+CalibrationError CalibrationLib::storeColorCalibration(const char* key, const ColorCalibration& calibration) {
+  uint8_t buffer[ColorCalibration::SERIALIZED_SIZE];
+  size_t size = calibration.serialize(buffer, sizeof(buffer));
+  if (size == 0) return reportError(CAL_INVALID_PARAM);
+  return storeBlob(key, buffer, size);
+}
+
+CalibrationError CalibrationLib::loadColorCalibration(const char* key, ColorCalibration& calibration) {
+  uint8_t buffer[ColorCalibration::SERIALIZED_SIZE];
+  CalibrationResult<size_t> result = loadBlob(key, buffer, sizeof(buffer));
+  if (!result) return result.error;
+  if (!calibration.deserialize(buffer, result.value)) return reportError(CAL_READ_ERROR);
+  return CAL_OK;
+}
+
+CalibrationError CalibrationLib::storeDriftMonitor(const char* key, const DriftMonitor& monitor) {
+  uint8_t buffer[DriftMonitor::SERIALIZED_SIZE];
+  size_t size = monitor.serialize(buffer, sizeof(buffer));
+  if (size == 0) return reportError(CAL_INVALID_PARAM);
+  return storeBlob(key, buffer, size);
+}
+
+CalibrationError CalibrationLib::loadDriftMonitor(const char* key, DriftMonitor& monitor) {
+  uint8_t buffer[DriftMonitor::SERIALIZED_SIZE];
+  CalibrationResult<size_t> result = loadBlob(key, buffer, sizeof(buffer));
+  if (!result) return result.error;
+  if (!monitor.deserialize(buffer, result.value)) return reportError(CAL_READ_ERROR);
+  return CAL_OK;
+}
+
+CalibrationError CalibrationLib::storeKalmanTuning(const char* key, const KalmanFilterBase& filter) {
+  uint8_t buffer[KalmanFilterBase::MAX_TUNING_SIZE];
+  size_t size = filter.serializeTuning(buffer, sizeof(buffer));
+  if (size == 0) return reportError(CAL_INVALID_PARAM);
+  return storeBlob(key, buffer, size);
+}
+
+CalibrationError CalibrationLib::loadKalmanTuning(const char* key, KalmanFilterBase& filter) {
+  uint8_t buffer[KalmanFilterBase::MAX_TUNING_SIZE];
+  CalibrationResult<size_t> result = loadBlob(key, buffer, sizeof(buffer));
+  if (!result) return result.error;
+  if (!filter.deserializeTuning(buffer, result.value)) return reportError(CAL_READ_ERROR);
+  return CAL_OK;
+}
+
+CalibrationError CalibrationLib::storeKalmanState(const char* key, const KalmanFilterBase& filter) {
+  uint8_t buffer[KalmanFilterBase::MAX_STATE_SIZE];
+  size_t size = filter.serializeState(buffer, sizeof(buffer));
+  if (size == 0) return reportError(CAL_INVALID_PARAM);
+  return storeBlob(key, buffer, size);
+}
+
+CalibrationError CalibrationLib::loadKalmanState(const char* key, KalmanFilterBase& filter) {
+  uint8_t buffer[KalmanFilterBase::MAX_STATE_SIZE];
+  CalibrationResult<size_t> result = loadBlob(key, buffer, sizeof(buffer));
+  if (!result) return result.error;
+  if (!filter.deserializeState(buffer, result.value)) return reportError(CAL_READ_ERROR);
+  return CAL_OK;
+}
+
+CalibrationError CalibrationLib::storeCalibrationTable(const char* key, const CalibrationTable& table) {
+  uint8_t buffer[CalibrationTable::MAX_SERIALIZED_SIZE];
+  size_t size = table.serialize(buffer, sizeof(buffer));
+  if (size == 0) return reportError(CAL_INVALID_PARAM);
+  return storeBlob(key, buffer, size);
+}
+
+CalibrationError CalibrationLib::loadCalibrationTable(const char* key, CalibrationTable& table) {
+  uint8_t buffer[CalibrationTable::MAX_SERIALIZED_SIZE];
+  CalibrationResult<size_t> result = loadBlob(key, buffer, sizeof(buffer));
+  if (!result) return result.error;
+  if (!table.deserialize(buffer, result.value)) return reportError(CAL_READ_ERROR);
+  return CAL_OK;
+}
+
+CalibrationError CalibrationLib::storeOffset(const char* key, const SampleAccumulator& samples, float reference) {
+  if (samples.count() == 0) return reportError(CAL_INVALID_PARAM);
+  return trySetCalibrationValue(key, samples.offsetTo(reference));
+}
+
+CalibrationError CalibrationLib::storeOffset(const char* key, RobustSampleBuffer& samples, float reference,
+                                             RobustMode mode) {
+  if (samples.count() == 0) return reportError(CAL_INVALID_PARAM);
+  return trySetCalibrationValue(key, samples.offsetTo(reference, mode));
+}
+
+CalibrationError CalibrationLib::storeOffset(const char* key, const StreamingQuantile& samples, float reference) {
+  if (samples.count() == 0) return reportError(CAL_INVALID_PARAM);
+  return trySetCalibrationValue(key, samples.offsetTo(reference));
+}
+
+CalibrationError CalibrationLib::storeOffsets(const char* const* keys, const SampleAccumulator* samples,
+                                              const float* references, size_t count) {
+  if (!_initialized) return reportError(CAL_NOT_INITIALIZED);
+  if (!keys || !samples) return reportError(CAL_INVALID_PARAM);
+  // Rollback only clears the batch flag, so reject bad input before the
+  // first write rather than after some offsets are already stored
+  for (size_t i = 0; i < count; i++) {
+    if (!validateKey(keys[i]) || samples[i].count() == 0) return reportError(CAL_INVALID_PARAM);
+  }
+  bool ownBatch = !_batchMode;
+  if (ownBatch && !batchBegin()) return CAL_NOT_INITIALIZED;
+
+  CalibrationError error = CAL_OK;
+  for (size_t i = 0; i < count && error == CAL_OK; i++) {
+    error = storeOffset(keys[i], samples[i], references ? references[i] : 0.0f);
+  }
+  if (ownBatch) {
+    if (error != CAL_OK) batchRollback();
+    else if (!batchCommit()) error = CAL_NOT_INITIALIZED;
+  }
+  return error;
+}
+
+// Legacy bool API, implemented on top of the result variants. A missing key
+// is not treated as an error here, matching the original behaviour.
 bool CalibrationLib::setCalibrationValue(const char* key, int value) {
-  if (!_initialized) return false;
-  return _preferences.putInt(key, value);
+  CalibrationError error = trySetCalibrationValue(key, value);
+  if (error != CAL_OK) _lastError = error;
+  return error == CAL_OK;
 }
 
 bool CalibrationLib::setCalibrationValue(const char* key, float value) {
-  if (!_initialized) return false;
-  return _preferences.putFloat(key, value);
+  CalibrationError error = trySetCalibrationValue(key, value);
+  if (error != CAL_OK) _lastError = error;
+  return error == CAL_OK;
 }
 
 bool CalibrationLib::setCalibrationValue(const char* key, const char* value) {
-  if (!_initialized) return false;
-  return _preferences.putString(key, value);
+  CalibrationError error = trySetCalibrationValue(key, value);
+  if (error != CAL_OK) _lastError = error;
+  return error == CAL_OK;
 }
 
 bool CalibrationLib::getCalibrationValue(const char* key, int& value, int defaultValue) {
-  if (!_initialized) {
-    value = defaultValue;
-    return false;
-  }
-  
-  value = _preferences.getInt(key, defaultValue);
-  return _preferences.isKey(key);
+  CalibrationResult<int> result = tryGetCalibrationInt(key);
+  if (result.error != CAL_OK && result.error != CAL_NOT_FOUND) _lastError = result.error;
+  value = result.valueOr(defaultValue);
+  return result.ok();
 }
 
 bool CalibrationLib::getCalibrationValue(const char* key, float& value, float defaultValue) {
-  if (!_initialized) {
-    value = defaultValue;
-    return false;
-  }
-  
-  value = _preferences.getFloat(key, defaultValue);
-  return _preferences.isKey(key);
+  CalibrationResult<float> result = tryGetCalibrationFloat(key);
+  if (result.error != CAL_OK && result.error != CAL_NOT_FOUND) _lastError = result.error;
+  value = result.valueOr(defaultValue);
+  return result.ok();
 }
 
 bool CalibrationLib::getCalibrationValue(const char* key, String& value, const char* defaultValue) {
-  if (!_initialized) {
-    value = defaultValue;
-    return false;
-  }
-  
-  value = _preferences.getString(key, defaultValue);
-  return _preferences.isKey(key);
+  CalibrationResult<String> result = tryGetCalibrationString(key);
+  if (result.error != CAL_OK && result.error != CAL_NOT_FOUND) _lastError = result.error;
+  value = result.ok() ? result.value : String(defaultValue);
+  return result.ok();
 }
 
 bool CalibrationLib::hasCalibrationValue(const char* key) {
+  CAL_SCOPE(CAL_OP_GET, key);
   if (!_initialized) return false;
+  CAL_COUNT(nvsReads, 1);
   return _preferences.isKey(key);
 }
 
 bool CalibrationLib::removeCalibrationValue(const char* key) {
+  CAL_SCOPE(CAL_OP_REMOVE, key);
   if (!_initialized) return false;
+  CAL_COUNT(nvsWrites, 1);
   return _preferences.remove(key);
 }
 
 bool CalibrationLib::clearAllCalibrationValues() {
+  CAL_SCOPE(CAL_OP_CLEAR, nullptr);
   if (!_initialized) return false;
+  CAL_COUNT(nvsWrites, 1);
   return _preferences.clear();
 }
 
+// Parsed documents copy every string, at most the input length, and each
+// member takes at least four characters ("k":1) of input
+static size_t importDocumentCapacity(size_t length) {
+  return length + (length / 4 + 1) * JSON_OBJECT_SIZE(1);
+}
+
 bool CalibrationLib::exportToJson(String& jsonString) {
+  CAL_SCOPE(CAL_OP_EXPORT, nullptr);
+  if (!_initialized) return false;
+  
+  DynamicJsonDocument doc(exportDocumentCapacity());
+  buildExportDocument(doc.to<JsonObject>());
+  if (doc.overflowed()) {
+    setError(CAL_MEMORY_ERROR);
+    return false;
+  }
+  
+  CAL_SCOPE(CAL_OP_JSON_SERIALIZE, nullptr);
+  serializeJson(doc, jsonString);
+  return true;
+}
+
+bool CalibrationLib::importFromJson(const String& jsonString) {
+  CAL_SCOPE(CAL_OP_IMPORT, nullptr);
   if (!_initialized) return false;
   
-  StaticJsonDocument<512> doc;
-  JsonObject root = doc.to<JsonObject>();
+  if (jsonString.length() > CALIBRATION_MAX_IMPORT_SIZE) {
+    setError(CAL_MEMORY_ERROR);
+    return false;
+  }
+  DynamicJsonDocument doc(importDocumentCapacity(jsonString.length()));
+  DeserializationError error;
+  {
+    CAL_SCOPE(CAL_OP_JSON_PARSE, nullptr);
+    error = deserializeJson(doc, jsonString);
+  }
   
+  if (error == DeserializationError::NoMemory) setError(CAL_MEMORY_ERROR);
+  if (error) return false;
+  
+  applyImportDocument(doc.as<JsonObject>());
+  return true;
+}
+
+// Pool space buildExportDocument() needs: one slot per entry plus the
+// copied key, string values, and a nested slot and base64 text per blob
+size_t CalibrationLib::exportDocumentCapacity() {
+  size_t capacity = 0;
+  for (size_t i = 0; i < _preferences.freeEntries(); i++) {
+    String key = _preferences.key(i);
+    String type = _preferences.getType(key.c_str());
+    
+    if (type == "i" || type == "f") {
+      capacity += JSON_OBJECT_SIZE(1) + JSON_STRING_SIZE(key.length());
+    } else if (type == "s") {
+      capacity += JSON_OBJECT_SIZE(1) + JSON_STRING_SIZE(key.length()) +
+                  JSON_STRING_SIZE(_preferences.getString(key.c_str()).length());
+    } else if (type == "b") {
+      size_t length = _preferences.getBytesLength(key.c_str());
+      capacity += JSON_OBJECT_SIZE(1) + JSON_STRING_SIZE(key.length()) +
+                  JSON_OBJECT_SIZE(1) + JSON_STRING_SIZE(4 * ((length + 2) / 3));
+    }
+  }
+  return capacity;
+}
+
+void CalibrationLib::buildExportDocument(JsonObject root) {
+  CAL_SCOPE(CAL_OP_NVS_READ, nullptr);
   // Get all keys and their values
   for (size_t i = 0; i < _preferences.freeEntries(); i++) {
     String key = _preferences.key(i);
@@ -222,22 +681,27 @@ bool CalibrationLib::exportToJson(String& jsonString) {
       root[key] = _preferences.getFloat(key.c_str());
     } else if (type == "s") {
       root[key] = _preferences.getString(key.c_str());
+    } else if (type == "b") {
+      // Binary entries (transforms, tables, tuning) go out as base64
+      // under a "blob" tag so import can tell them from strings
+      size_t length = _preferences.getBytesLength(key.c_str());
+      if (length == 0) continue;
+      size_t encodedLength = 0;
+      mbedtls_base64_encode(nullptr, 0, &encodedLength, nullptr, length);
+      uint8_t* data = new uint8_t[length];
+      char* encoded = new char[encodedLength];
+      if (_preferences.getBytes(key.c_str(), data, length) == length &&
+          mbedtls_base64_encode((unsigned char*)encoded, encodedLength, &encodedLength, data, length) == 0) {
+        // char* (not const) so the document keeps its own copy
+        root[key]["blob"] = encoded;
+      }
+      delete[] encoded;
+      delete[] data;
     }
   }
-  
-  serializeJson(doc, jsonString);
-  return true;
 }
 
-bool CalibrationLib::importFromJson(const String& jsonString) {
-  if (!_initialized) return false;
-  
-  StaticJsonDocument<512> doc;
-  DeserializationError error = deserializeJson(doc, jsonString);
-  
-  if (error) return false;
-  
-  JsonObject root = doc.as<JsonObject>();
+void CalibrationLib::applyImportDocument(JsonObject root) {
   for (JsonPair kv : root) {
     if (kv.value().is<int>()) {
       setCalibrationValue(kv.key().c_str(), kv.value().as<int>());
@@ -245,22 +709,34 @@ bool CalibrationLib::importFromJson(const String& jsonString) {
       setCalibrationValue(kv.key().c_str(), kv.value().as<float>());
     } else if (kv.value().is<const char*>()) {
       setCalibrationValue(kv.key().c_str(), kv.value().as<const char*>());
+    } else if (kv.value()["blob"].is<const char*>()) {
+      const char* encoded = kv.value()["blob"].as<const char*>();
+      size_t encodedLength = strlen(encoded);
+      size_t length = 0;
+      mbedtls_base64_decode(nullptr, 0, &length, (const unsigned char*)encoded, encodedLength);
+      if (length == 0) continue;
+      uint8_t* data = new uint8_t[length];
+      if (mbedtls_base64_decode(data, length, &length, (const unsigned char*)encoded, encodedLength) == 0) {
+        storeBlob(kv.key().c_str(), data, length);
+      }
+      delete[] data;
     }
   }
-  
-  return true;
 }
 
 bool CalibrationLib::setCalibrationVersion(const char* version) {
+  CAL_SCOPE(CAL_OP_SET, "_version");
   if (!_initialized) return false;
-  return _preferences.putString("_version", version);
+  return recordWrite(_preferences.putString("_version", version)) == CAL_OK;
 }
 
 bool CalibrationLib::getCalibrationVersion(String& version) {
+  CAL_SCOPE(CAL_OP_GET, "_version");
   if (!_initialized) {
     version = "";
     return false;
   }
+  CAL_COUNT(nvsReads, 1);
   version = _preferences.getString("_version", "");
   return _preferences.isKey("_version");
 }
@@ -272,16 +748,19 @@ bool CalibrationLib::isCalibrationOutdated(const char* currentVersion) {
 }
 
 bool CalibrationLib::setCalibrationTimestamp(unsigned long timestamp) {
+  CAL_SCOPE(CAL_OP_SET, "_timestamp");
   if (!_initialized) return false;
   if (timestamp == 0) timestamp = millis();
-  return _preferences.putULong("_timestamp", timestamp);
+  return recordWrite(_preferences.putULong("_timestamp", timestamp)) == CAL_OK;
 }
 
 bool CalibrationLib::getCalibrationTimestamp(unsigned long& timestamp) {
+  CAL_SCOPE(CAL_OP_GET, "_timestamp");
   if (!_initialized) {
     timestamp = 0;
     return false;
   }
+  CAL_COUNT(nvsReads, 1);
   timestamp = _preferences.getULong("_timestamp", 0);
   return _preferences.isKey("_timestamp");
 }
@@ -303,6 +782,7 @@ bool CalibrationLib::enableEncryption(const char* key) {
     }
     
     // Generate encryption key using SHA256
+    CAL_SCOPE(CAL_OP_KEY_DERIVE, nullptr);
     uint8_t derivedKey[32];
     mbedtls_md_context_t ctx;
     mbedtls_md_init(&ctx);
@@ -316,7 +796,7 @@ bool CalibrationLib::enableEncryption(const char* key) {
     memcpy(_encryptionKey, derivedKey, 32);
     _encryptionEnabled = true;
     
-    log(DEBUG_INFO, "Encryption enabled");
+    CAL_LOG(DEBUG_INFO, "Encryption enabled");
     return true;
 }
 
@@ -329,11 +809,13 @@ bool CalibrationLib::disableEncryption() {
     memset(_encryptionKey, 0, sizeof(_encryptionKey));
     _encryptionEnabled = false;
     
-    log(DEBUG_INFO, "Encryption disabled");
+    CAL_LOG(DEBUG_INFO, "Encryption disabled");
     return true;
 }
 
 bool CalibrationLib::encryptData(const void* data, size_t size, uint8_t* encrypted, size_t& encSize) {
+    CAL_SCOPE(CAL_OP_ENCRYPT, nullptr);
+    CAL_COUNT(encryptOps, 1);
     if (!_encryptionEnabled || !data || !encrypted) {
         setError(CAL_ENCRYPTION_ERROR);
         return false;
@@ -363,6 +845,8 @@ bool CalibrationLib::encryptData(const void* data, size_t size, uint8_t* encrypt
 }
 
 bool CalibrationLib::decryptData(const uint8_t* encrypted, size_t encSize, void* data, size_t& size) {
+    CAL_SCOPE(CAL_OP_DECRYPT, nullptr);
+    CAL_COUNT(decryptOps, 1);
     if (!_encryptionEnabled || !encrypted || !data || encSize % 16 != 0) {
         setError(CAL_ENCRYPTION_ERROR);
         return false;
@@ -394,5 +878,296 @@ bool CalibrationLib::decryptData(const uint8_t* encrypted, size_t encSize, void*
     delete[] decrypted;
     mbedtls_aes_free(&aes);
     
+    return true;
+}
+
+// Encrypted export bundles
+//
+// Layout: "CLB1" | length (u32 LE) | nonce (16) | ciphertext (length) | tag (32)
+// The payload is the exportToJson document encrypted with AES-256-CTR. The tag is
+// HMAC-SHA256 over everything before it. Encryption and MAC keys are derived from
+// the enableEncryption key, so both ends only need to share that passphrase.
+static const uint8_t BUNDLE_MAGIC[4] = {'C', 'L', 'B', '1'};
+static const size_t BUNDLE_NONCE_SIZE = 16;
+static const size_t BUNDLE_TAG_SIZE = 32;
+
+namespace {
+
+// Print adapter that encrypts and MACs whatever the JSON serializer writes,
+// so the plaintext never exists as a complete buffer.
+class BundleWriter : public Print {
+public:
+    BundleWriter(Print& output, mbedtls_aes_context& aes, mbedtls_md_context_t& mac, uint8_t* nonce) :
+        _output(output), _aes(aes), _mac(mac), _nonce(nonce), _offset(0), _ok(true) {
+        memset(_stream, 0, sizeof(_stream));
+    }
+    
+    size_t write(uint8_t c) override {
+        return write(&c, 1);
+    }
+    
+    size_t write(const uint8_t* buffer, size_t size) override {
+        uint8_t chunk[64];
+        size_t done = 0;
+        while (done < size) {
+            size_t n = size - done < sizeof(chunk) ? size - done : sizeof(chunk);
+            mbedtls_aes_crypt_ctr(&_aes, n, &_offset, _nonce, _stream, buffer + done, chunk);
+            mbedtls_md_hmac_update(&_mac, chunk, n);
+            if (_output.write(chunk, n) != n) {
+                _ok = false;
+                break;
+            }
+            done += n;
+        }
+        return done;
+    }
+    
+    bool ok() const { return _ok; }
+
+private:
+    Print& _output;
+    mbedtls_aes_context& _aes;
+    mbedtls_md_context_t& _mac;
+    uint8_t* _nonce;
+    uint8_t _stream[16];
+    size_t _offset;
+    bool _ok;
+};
+
+// Stream adapter that authenticates and decrypts a fixed-length ciphertext
+// one byte at a time as the JSON parser consumes it.
+class BundleReader : public Stream {
+public:
+    BundleReader(Stream& input, uint32_t length, mbedtls_aes_context& aes, mbedtls_md_context_t& mac, uint8_t* nonce) :
+        _input(input), _remaining(length), _aes(aes), _mac(mac), _nonce(nonce), _offset(0), _peeked(-1) {
+        memset(_stream, 0, sizeof(_stream));
+    }
+    
+    int available() override {
+        return _peeked >= 0 ? 1 : (_remaining > 0 ? 1 : 0);
+    }
+    
+    int peek() override {
+        if (_peeked < 0) {
+            _peeked = next();
+        }
+        return _peeked;
+    }
+    
+    int read() override {
+        int c = peek();
+        _peeked = -1;
+        return c;
+    }
+    
+    size_t write(uint8_t) override {
+        return 0;
+    }
+    
+    // Feed any ciphertext the parser did not consume into the MAC
+    bool drain() {
+        while (_remaining > 0) {
+            if (next() < 0) return false;
+        }
+        return true;
+    }
+
+private:
+    int next() {
+        if (_remaining == 0) return -1;
+        uint8_t encrypted;
+        if (_input.readBytes(&encrypted, 1) != 1) {
+            _remaining = 0;
+            return -1;
+        }
+        _remaining--;
+        mbedtls_md_hmac_update(&_mac, &encrypted, 1);
+        uint8_t plain;
+        mbedtls_aes_crypt_ctr(&_aes, 1, &_offset, _nonce, _stream, &encrypted, &plain);
+        return plain;
+    }
+    
+    Stream& _input;
+    uint32_t _remaining;
+    mbedtls_aes_context& _aes;
+    mbedtls_md_context_t& _mac;
+    uint8_t* _nonce;
+    uint8_t _stream[16];
+    size_t _offset;
+    int _peeked;
+};
+
+} // namespace
+
+bool CalibrationLib::deriveBundleKey(const char* label, uint8_t* out) {
+    CAL_SCOPE(CAL_OP_KEY_DERIVE, label);
+    mbedtls_md_context_t ctx;
+    mbedtls_md_init(&ctx);
+    bool ok = mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0) == 0 &&
+              mbedtls_md_starts(&ctx) == 0 &&
+              mbedtls_md_update(&ctx, _encryptionKey, sizeof(_encryptionKey)) == 0 &&
+              mbedtls_md_update(&ctx, (const unsigned char*)label, strlen(label)) == 0 &&
+              mbedtls_md_finish(&ctx, out) == 0;
+    mbedtls_md_free(&ctx);
+    return ok;
+}
+
+bool CalibrationLib::exportEncryptedBundle(Print& output) {
+    CAL_SCOPE(CAL_OP_EXPORT, nullptr);
+    if (!_initialized) {
+        setError(CAL_NOT_INITIALIZED);
+        return false;
+    }
+    if (!_encryptionEnabled) {
+        setError(CAL_ENCRYPTION_ERROR);
+        return false;
+    }
+    
+    DynamicJsonDocument doc(exportDocumentCapacity());
+    buildExportDocument(doc.to<JsonObject>());
+    if (doc.overflowed()) {
+        setError(CAL_MEMORY_ERROR);
+        return false;
+    }
+    
+    uint8_t encKey[32], macKey[32];
+    if (!deriveBundleKey("bundle-enc", encKey) || !deriveBundleKey("bundle-mac", macKey)) {
+        setError(CAL_ENCRYPTION_ERROR);
+        return false;
+    }
+    
+    uint8_t header[sizeof(BUNDLE_MAGIC) + 4 + BUNDLE_NONCE_SIZE];
+    uint32_t length = measureJson(doc);
+    memcpy(header, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC));
+    for (int i = 0; i < 4; i++) {
+        header[4 + i] = (length >> (8 * i)) & 0xFF;
+    }
+    for (size_t i = 0; i < BUNDLE_NONCE_SIZE; i += 4) {
+        uint32_t r = esp_random();
+        memcpy(header + 8 + i, &r, 4);
+    }
+    // Low four bytes of the counter block start at zero
+    memset(header + 8 + BUNDLE_NONCE_SIZE - 4, 0, 4);
+    uint8_t nonce[BUNDLE_NONCE_SIZE];
+    memcpy(nonce, header + 8, BUNDLE_NONCE_SIZE);
+    
+    mbedtls_aes_context aes;
+    mbedtls_md_context_t mac;
+    mbedtls_aes_init(&aes);
+    mbedtls_md_init(&mac);
+    mbedtls_aes_setkey_enc(&aes, encKey, 256);
+    mbedtls_md_setup(&mac, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1);
+    mbedtls_md_hmac_starts(&mac, macKey, sizeof(macKey));
+    mbedtls_md_hmac_update(&mac, header, sizeof(header));
+    
+    CAL_COUNT(encryptOps, 1);
+    bool ok = output.write(header, sizeof(header)) == sizeof(header);
+    if (ok) {
+        CAL_SCOPE(CAL_OP_ENCRYPT, nullptr);
+        BundleWriter writer(output, aes, mac, nonce);
+        serializeJson(doc, writer);
+        ok = writer.ok();
+    }
+    
+    uint8_t tag[BUNDLE_TAG_SIZE];
+    mbedtls_md_hmac_finish(&mac, tag);
+    ok = ok && output.write(tag, sizeof(tag)) == sizeof(tag);
+    
+    mbedtls_md_free(&mac);
+    mbedtls_aes_free(&aes);
+    memset(encKey, 0, sizeof(encKey));
+    memset(macKey, 0, sizeof(macKey));
+    
+    if (!ok) {
+        setError(CAL_WRITE_ERROR);
+        return false;
+    }
+    CAL_LOG(DEBUG_INFO, "Exported encrypted bundle (%u bytes)", (unsigned)length);
+    return true;
+}
+
+bool CalibrationLib::importEncryptedBundle(Stream& input) {
+    CAL_SCOPE(CAL_OP_IMPORT, nullptr);
+    if (!_initialized) {
+        setError(CAL_NOT_INITIALIZED);
+        return false;
+    }
+    if (!_encryptionEnabled) {
+        setError(CAL_ENCRYPTION_ERROR);
+        return false;
+    }
+    
+    uint8_t header[sizeof(BUNDLE_MAGIC) + 4 + BUNDLE_NONCE_SIZE];
+    if (input.readBytes(header, sizeof(header)) != sizeof(header) ||
+        memcmp(header, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC)) != 0) {
+        setError(CAL_READ_ERROR);
+        return false;
+    }
+    uint32_t length = 0;
+    for (int i = 0; i < 4; i++) {
+        length |= (uint32_t)header[4 + i] << (8 * i);
+    }
+    if (length > CALIBRATION_MAX_IMPORT_SIZE) {
+        setError(CAL_MEMORY_ERROR);
+        return false;
+    }
+    uint8_t nonce[BUNDLE_NONCE_SIZE];
+    memcpy(nonce, header + 8, BUNDLE_NONCE_SIZE);
+    
+    uint8_t encKey[32], macKey[32];
+    if (!deriveBundleKey("bundle-enc", encKey) || !deriveBundleKey("bundle-mac", macKey)) {
+        setError(CAL_ENCRYPTION_ERROR);
+        return false;
+    }
+    
+    mbedtls_aes_context aes;
+    mbedtls_md_context_t mac;
+    mbedtls_aes_init(&aes);
+    mbedtls_md_init(&mac);
+    mbedtls_aes_setkey_enc(&aes, encKey, 256);
+    mbedtls_md_setup(&mac, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1);
+    mbedtls_md_hmac_starts(&mac, macKey, sizeof(macKey));
+    mbedtls_md_hmac_update(&mac, header, sizeof(header));
+    
+    CAL_COUNT(decryptOps, 1);
+    DynamicJsonDocument doc(importDocumentCapacity(length));
+    DeserializationError error;
+    bool complete;
+    {
+        CAL_SCOPE(CAL_OP_DECRYPT, nullptr);
+        BundleReader reader(input, length, aes, mac, nonce);
+        error = deserializeJson(doc, reader);
+        complete = reader.drain();
+    }
+    
+    uint8_t expected[BUNDLE_TAG_SIZE], received[BUNDLE_TAG_SIZE];
+    mbedtls_md_hmac_finish(&mac, expected);
+    mbedtls_md_free(&mac);
+    mbedtls_aes_free(&aes);
+    memset(encKey, 0, sizeof(encKey));
+    memset(macKey, 0, sizeof(macKey));
+    
+    if (!complete || input.readBytes(received, sizeof(received)) != sizeof(received)) {
+        setError(CAL_READ_ERROR);
+        return false;
+    }
+    
+    // Constant-time tag comparison; nothing is applied unless it matches
+    uint8_t diff = 0;
+    for (size_t i = 0; i < BUNDLE_TAG_SIZE; i++) {
+        diff |= expected[i] ^ received[i];
+    }
+    if (diff != 0) {
+        CAL_LOG(DEBUG_ERROR, "Bundle authentication failed");
+        setError(CAL_ENCRYPTION_ERROR);
+        return false;
+    }
+    if (error) {
+        setError(error == DeserializationError::NoMemory ? CAL_MEMORY_ERROR : CAL_READ_ERROR);
+        return false;
+    }
+    
+    applyImportDocument(doc.as<JsonObject>());
+    CAL_LOG(DEBUG_INFO, "Imported encrypted bundle (%u bytes)", (unsigned)length);
     return true;
 }
\ No newline at end of file
@@ -2,8 +2,25 @@
 #define CALIBRATION_LIB_H
 
 #include <Arduino.h>
+#include <atomic>
 #include <Preferences.h>
 #include <ArduinoJson.h>
+#include "CalibrationLogBuffer.h"
+#include "CalibrationProfiler.h"
+#include "CalibrationMetrics.h"
+#include "CalibrationTransform.h"
+#include "CalibrationFixedPoint.h"
+#include "CalibrationLUT.h"
+#include "CalibrationFitter.h"
+#include "CalibrationAccumulator.h"
+#include "CalibrationRobust.h"
+#include "CalibrationAxis.h"
+#include "CalibrationThermal.h"
+#include "CalibrationColor.h"
+#include "CalibrationPipeline.h"
+#include "CalibrationDrift.h"
+#include "CalibrationKalman.h"
+#include "CalibrationTable.h"
 
 // Error codes
 enum CalibrationError {
@@ -13,7 +30,19 @@ enum CalibrationError {
     CAL_WRITE_ERROR = -3,
     CAL_READ_ERROR = -4,
     CAL_MEMORY_ERROR = -5,
-    CAL_ENCRYPTION_ERROR = -6
+    CAL_ENCRYPTION_ERROR = -6,
+    CAL_NOT_FOUND = -7
+};
+
+// Value and status returned together by the tryGet* methods
+template<typename T>
+struct CalibrationResult {
+    T value;
+    CalibrationError error;
+    
+    bool ok() const { return error == CAL_OK; }
+    explicit operator bool() const { return ok(); }
+    T valueOr(const T& fallback) const { return ok() ? value : fallback; }
 };
 
 // Debug levels
@@ -24,6 +53,25 @@ enum DebugLevel {
     DEBUG_VERBOSE = 3
 };
 
+// Log delivery modes
+enum LogMode {
+    LOG_IMMEDIATE = 0,  // Format and print at the call site
+    LOG_DEFERRED = 1    // Record binary entries, print on flushLog()
+};
+
+// Highest debug level compiled into the library. Log statements above this
+// level are removed at compile time; e.g. build with
+// -DCALIBRATION_LOG_LEVEL=DEBUG_NONE for production firmware.
+#ifndef CALIBRATION_LOG_LEVEL
+#define CALIBRATION_LOG_LEVEL DEBUG_VERBOSE
+#endif
+
+// Largest JSON text importFromJson() and importEncryptedBundle() accept.
+// Import documents are sized from the input, so this bounds their heap use.
+#ifndef CALIBRATION_MAX_IMPORT_SIZE
+#define CALIBRATION_MAX_IMPORT_SIZE 8192
+#endif
+
 class CalibrationLib {
 public:
     // Constructor
@@ -32,6 +80,11 @@ public:
     // Debug and logging methods
     void setDebugLevel(DebugLevel level);
     void setDebugOutput(Print* output);
+    // The ring is allocated on the first switch to LOG_DEFERRED and kept
+    // until the instance is destroyed; switching back flushes it
+    bool setLogMode(LogMode mode, size_t bufferEntries = 32);
+    size_t flushLog(size_t maxEntries = 0);
+    uint32_t getDroppedLogCount() const;
     CalibrationError getLastError() const;
     const char* getErrorString(CalibrationError error) const;
     
@@ -48,6 +101,19 @@ public:
     bool enableEncryption(const char* key);
     bool disableEncryption();
     
+    // Latency instrumentation (requires CALIBRATION_ENABLE_PROFILING)
+    bool getLatencyHistogram(CalibrationOp op, LatencyHistogram& histogram) const;
+    void printLatencyStats(Print& output) const;
+    void resetLatencyStats();
+    
+    // Trace hooks for external profilers; pass nullptr to remove
+    void setTraceHook(CalibrationTraceHook hook, void* context = nullptr);
+    
+    // Operation counters and metrics exposition
+    const CalibrationMetrics& getMetrics() const;
+    void resetMetrics();
+    void writeMetrics(Print& output, MetricsFormat format = METRICS_PROMETHEUS) const;
+    
     // Memory management
     size_t getFreeSpace() const;
     size_t getUsedSpace() const;
@@ -64,6 +130,64 @@ public:
     bool getCalibrationValue(const char* key, float& value, float defaultValue = 0.0f);
     bool getCalibrationValue(const char* key, String& value, const char* defaultValue = "");
     
+    // Result-returning variants. These report status per call and never
+    // modify getLastError(). The instance itself is not thread-safe: calls
+    // from several tasks still need a lock around the shared instance.
+    CalibrationError trySetCalibrationValue(const char* key, int value);
+    CalibrationError trySetCalibrationValue(const char* key, float value);
+    CalibrationError trySetCalibrationValue(const char* key, const char* value);
+    
+    CalibrationResult<int> tryGetCalibrationInt(const char* key);
+    CalibrationResult<float> tryGetCalibrationFloat(const char* key);
+    CalibrationResult<String> tryGetCalibrationString(const char* key);
+    
+    // Binary values, for models and tables stored as one entry
+    CalibrationError storeBlob(const char* key, const void* data, size_t size);
+    CalibrationResult<size_t> loadBlob(const char* key, void* buffer, size_t size);
+    
+    // Per-channel transform models
+    CalibrationError storeTransform(const char* channel, const CalibrationTransform& transform);
+    CalibrationError loadTransform(const char* channel, CalibrationTransform& transform);
+    
+    // 3-axis bias and correction matrix models
+    CalibrationError storeAxisCalibration(const char* key, const AxisCalibration& calibration);
+    CalibrationError loadAxisCalibration(const char* key, AxisCalibration& calibration);
+    
+    // Temperature-indexed offset/scale tables
+    CalibrationError storeThermalCalibration(const char* key, const ThermalCalibration& calibration);
+    CalibrationError loadThermalCalibration(const char* key, ThermalCalibration& calibration);
+    
+    // RGB LED gain, gamma and white-balance models
+    CalibrationError storeColorCalibration(const char* key, const ColorCalibration& calibration);
+    CalibrationError loadColorCalibration(const char* key, ColorCalibration& calibration);
+    
+    // Drift residuals and operating time, kept across reboots
+    CalibrationError storeDriftMonitor(const char* key, const DriftMonitor& monitor);
+    CalibrationError loadDriftMonitor(const char* key, DriftMonitor& monitor);
+    
+    // Kalman noise tuning (Q, R) and checkpointed state (x, P), stored
+    // separately so a warm start never overwrites the tuning
+    CalibrationError storeKalmanTuning(const char* key, const KalmanFilterBase& filter);
+    CalibrationError loadKalmanTuning(const char* key, KalmanFilterBase& filter);
+    CalibrationError storeKalmanState(const char* key, const KalmanFilterBase& filter);
+    CalibrationError loadKalmanState(const char* key, KalmanFilterBase& filter);
+    
+    // All channels of a multi-channel offset/scale table in one entry
+    CalibrationError storeCalibrationTable(const char* key, const CalibrationTable& table);
+    CalibrationError loadCalibrationTable(const char* key, CalibrationTable& table);
+    
+    // Stores reference - mean as a float offset. storeOffsets() checks every
+    // key and accumulator first, then writes them inside one batch (opened
+    // only if none is active). Batches are not transactional: if a write
+    // fails partway, the offsets already written stay stored.
+    CalibrationError storeOffset(const char* key, const SampleAccumulator& samples, float reference = 0.0f);
+    CalibrationError storeOffsets(const char* const* keys, const SampleAccumulator* samples,
+                                  const float* references, size_t count);
+    // Same with an outlier-resistant aggregate instead of the mean
+    CalibrationError storeOffset(const char* key, RobustSampleBuffer& samples, float reference = 0.0f,
+                                 RobustMode mode = ROBUST_MEDIAN);
+    CalibrationError storeOffset(const char* key, const StreamingQuantile& samples, float reference = 0.0f);
+    
     bool hasCalibrationValue(const char* key);
     bool removeCalibrationValue(const char* key);
     bool clearAllCalibrationValues();
@@ -72,6 +196,10 @@ public:
     bool exportToJson(String& jsonString);
     bool importFromJson(const String& jsonString);
     
+    // Encrypted, authenticated export bundles (requires enableEncryption)
+    bool exportEncryptedBundle(Print& output);
+    bool importEncryptedBundle(Stream& input);
+    
     // Version control
     bool setCalibrationVersion(const char* version);
     bool getCalibrationVersion(String& version);
@@ -80,6 +208,8 @@ public:
     // Timestamp management
     bool setCalibrationTimestamp(unsigned long timestamp = 0);
     bool getCalibrationTimestamp(unsigned long& timestamp);
+    // Compares against millis(), which restarts on every boot; DriftMonitor
+    // keeps operating time that survives reboots
     bool isCalibrationExpired(unsigned long maxAgeMs);
 
 // Add in private section
@@ -89,15 +219,36 @@ private:
     bool _initialized;
     DebugLevel _debugLevel;
     Print* _debugOutput;
+    std::atomic<LogMode> _logMode;
+    CalibrationLogBuffer _logBuffer;
     CalibrationError _lastError;
     bool _encryptionEnabled;
     bool _batchMode;
+    char _namespace[16];
+    CalibrationTraceHook _traceHook;
+    void* _traceContext;
+    CalibrationMetrics _metrics;
+#if CALIBRATION_ENABLE_PROFILING
+    LatencyHistogram _latency[CAL_OP_COUNT];
+#endif
     
     // Internal helper methods
-    void log(DebugLevel level, const char* message, ...);
+    void log(DebugLevel level, const char* format, ...) __attribute__((format(printf, 3, 4)));
+    // CAL_LOG's immediate path: unwraps LogText arguments for log()
+    template<typename... Args>
+    void logValues(DebugLevel level, const char* format, Args... args) {
+        log(level, format, logArg(args)...);
+    }
     void setError(CalibrationError error);
+    CalibrationError reportError(CalibrationError error);
+    CalibrationError checkAccess(const char* key);
+    CalibrationError recordWrite(size_t written);
     bool encryptData(const void* data, size_t size, uint8_t* encrypted, size_t& encSize);
     bool decryptData(const uint8_t* encrypted, size_t encSize, void* data, size_t& size);
+    size_t exportDocumentCapacity();
+    void buildExportDocument(JsonObject root);
+    void applyImportDocument(JsonObject root);
+    bool deriveBundleKey(const char* label, uint8_t* out);
 };
 
 #endif
\ No newline at end of file
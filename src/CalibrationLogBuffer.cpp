@@ -0,0 +1,181 @@
+#include "CalibrationLogBuffer.h"
+#include <new>
+
+CalibrationLogBuffer::CalibrationLogBuffer() :
+    _entries(nullptr),
+    _mask(0),
+    _head(0),
+    _tail(0),
+    _dropped(0) {
+}
+
+CalibrationLogBuffer::~CalibrationLogBuffer() {
+    release();
+}
+
+bool CalibrationLogBuffer::allocate(size_t capacity) {
+    release();
+
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    _entries = new (std::nothrow) CalibrationLogEntry[size];
+    if (!_entries) {
+        return false;
+    }
+    for (size_t i = 0; i < size; i++) {
+        _entries[i].ready.store(0, std::memory_order_relaxed);
+    }
+    _mask = size - 1;
+    _head.store(0, std::memory_order_relaxed);
+    _tail.store(0, std::memory_order_relaxed);
+    _dropped.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+void CalibrationLogBuffer::release() {
+    delete[] _entries;
+    _entries = nullptr;
+    _mask = 0;
+}
+
+CalibrationLogEntry* CalibrationLogBuffer::reserve() {
+    if (!_entries) return nullptr;
+
+    // Claim the head slot; a failed exchange means another producer took
+    // it first and head now holds the next candidate
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    do {
+        uint32_t tail = _tail.load(std::memory_order_acquire);
+        if (head - tail > _mask) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+    } while (!_head.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel,
+                                          std::memory_order_relaxed));
+    return &_entries[head & _mask];
+}
+
+void CalibrationLogBuffer::publish(CalibrationLogEntry* entry) {
+    entry->ready.store(1, std::memory_order_release);
+}
+
+size_t CalibrationLogBuffer::pending() const {
+    return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed);
+}
+
+void CalibrationLogBuffer::setArg(CalibrationLogEntry& entry, ArgType type, uintptr_t raw) {
+    if (entry.argCount >= MAX_ARGS) return;
+    entry.args[entry.argCount] = raw;
+    entry.argTypes |= type << (2 * entry.argCount);
+    entry.argCount++;
+}
+
+void CalibrationLogBuffer::pack(CalibrationLogEntry& entry, double value) {
+    float narrowed = (float)value;
+    uint32_t raw;
+    memcpy(&raw, &narrowed, sizeof(raw));
+    setArg(entry, ARG_FLOAT, raw);
+}
+
+void CalibrationLogBuffer::pack(CalibrationLogEntry& entry, LogText value) {
+    // One copy fits in the entry; any further LogText is kept by pointer
+    if (entry.text[0] != '\0') {
+        setArg(entry, ARG_STRING, (uintptr_t)value.value);
+        return;
+    }
+    strncpy(entry.text, value.value ? value.value : "(null)", sizeof(entry.text) - 1);
+    entry.text[sizeof(entry.text) - 1] = '\0';
+    setArg(entry, ARG_STRING, 0);
+}
+
+void CalibrationLogBuffer::format(const CalibrationLogEntry& entry, char* buffer, size_t size) const {
+    // Walk the format one conversion at a time so each stored argument is
+    // passed to snprintf with its original type.
+    size_t used = 0;
+    uint8_t arg = 0;
+    const char* p = entry.format;
+
+    while (*p && used + 1 < size) {
+        if (*p != '%') {
+            buffer[used++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            buffer[used++] = '%';
+            p += 2;
+            continue;
+        }
+
+        char spec[16];
+        size_t len = 0;
+        spec[len++] = *p++;
+        while (*p && !strchr("diuxXcsfFeEgGp", *p) && len < sizeof(spec) - 2) {
+            spec[len++] = *p++;
+        }
+        if (!*p) break;
+        spec[len++] = *p++;
+        spec[len] = '\0';
+
+        int written = 0;
+        if (arg < entry.argCount) {
+            uintptr_t raw = entry.args[arg];
+            bool isLong = strchr(spec, 'l') != nullptr;
+            switch ((entry.argTypes >> (2 * arg)) & 0x3) {
+                case ARG_INT:
+                    written = isLong ? snprintf(buffer + used, size - used, spec, (long)(int32_t)raw)
+                                     : snprintf(buffer + used, size - used, spec, (int)raw);
+                    break;
+                case ARG_UINT:
+                    written = isLong ? snprintf(buffer + used, size - used, spec, (unsigned long)(uint32_t)raw)
+                                     : snprintf(buffer + used, size - used, spec, (unsigned)raw);
+                    break;
+                case ARG_FLOAT: {
+                    uint32_t bits = (uint32_t)raw;
+                    float value;
+                    memcpy(&value, &bits, sizeof(value));
+                    written = snprintf(buffer + used, size - used, spec, (double)value);
+                    break;
+                }
+                case ARG_STRING: {
+                    // Zero marks the copy held in the entry
+                    const char* text = raw ? (const char*)raw : entry.text;
+                    written = snprintf(buffer + used, size - used, spec, text);
+                    break;
+                }
+            }
+            arg++;
+        }
+        if (written > 0) {
+            used += (size_t)written < size - used ? (size_t)written : size - used - 1;
+        }
+    }
+    buffer[used] = '\0';
+}
+
+size_t CalibrationLogBuffer::drain(Print& output, size_t maxEntries) {
+    if (!_entries) return 0;
+
+    size_t count = 0;
+    char line[256];
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    while (maxEntries == 0 || count < maxEntries) {
+        if (tail == _head.load(std::memory_order_acquire)) break;
+
+        // Claimed but not yet filled: later slots wait for this one
+        CalibrationLogEntry& entry = _entries[tail & _mask];
+        if (!entry.ready.load(std::memory_order_acquire)) break;
+
+        int prefix = snprintf(line, sizeof(line), "[%lu] ", (unsigned long)entry.timestamp);
+        format(entry, line + prefix, sizeof(line) - prefix);
+        output.println(line);
+
+        entry.ready.store(0, std::memory_order_relaxed);
+        tail++;
+        _tail.store(tail, std::memory_order_release);
+        count++;
+    }
+    return count;
+}
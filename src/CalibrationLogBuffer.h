@@ -0,0 +1,104 @@
+#ifndef CALIBRATION_LOG_BUFFER_H
+#define CALIBRATION_LOG_BUFFER_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Compact binary log record. The format literal doubles as the message id;
+// arguments are stored raw and only formatted when the buffer is flushed.
+struct CalibrationLogEntry {
+    const char* format;
+    uint32_t timestamp;     // micros() when recorded
+    uint8_t level;
+    uint8_t argCount;
+    uint8_t argTypes;       // 2 bits per argument, see ArgType
+    char text[16];          // copy of the first LogText argument
+    uintptr_t args[4];
+    std::atomic<uint8_t> ready;   // set once the producer has filled the slot
+};
+
+// Marks a string argument that may not outlive the log call, such as a
+// caller's key or namespace buffer. The deferred log copies it into the
+// entry (15 characters, the NVS key limit); plain const char* arguments
+// are kept by pointer and must be literals or otherwise long-lived.
+//
+//   CAL_LOG(DEBUG_INFO, "Loaded %s", LogText{key});
+struct LogText {
+    const char* value;
+};
+
+inline const char* logArg(LogText text) { return text.value; }
+template<typename T>
+inline T logArg(T value) { return value; }
+
+// Multi-producer/single-consumer lock-free ring of log records. Producers
+// claim a slot with a compare-and-swap on the head, so tasks and ISRs may
+// log concurrently; each slot is marked ready when filled, and drain()
+// stops at the first slot still being written. Recording is a handful of
+// stores; formatting happens later in drain().
+class CalibrationLogBuffer {
+public:
+    static const uint8_t MAX_ARGS = 4;
+
+    CalibrationLogBuffer();
+    ~CalibrationLogBuffer();
+
+    // Allocates room for capacity entries (rounded up to a power of two)
+    bool allocate(size_t capacity);
+    void release();
+    bool isAllocated() const { return _entries != nullptr; }
+
+    template<typename... Args>
+    void record(uint8_t level, const char* format, Args... args) {
+        static_assert(sizeof...(Args) <= MAX_ARGS, "CalibrationLogBuffer: too many log arguments");
+        CalibrationLogEntry* entry = reserve();
+        if (!entry) return;
+        entry->format = format;
+        entry->timestamp = micros();
+        entry->level = level;
+        entry->argCount = 0;
+        entry->argTypes = 0;
+        entry->text[0] = '\0';
+        int unpack[] = {0, (pack(*entry, args), 0)...};
+        (void)unpack;
+        publish(entry);
+    }
+
+    // Formats and prints up to maxEntries pending records (0 = all)
+    size_t drain(Print& output, size_t maxEntries = 0);
+
+    // Claimed entries, including any a producer is still filling
+    size_t pending() const;
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    enum ArgType : uint8_t {
+        ARG_INT = 0,
+        ARG_UINT = 1,
+        ARG_FLOAT = 2,
+        ARG_STRING = 3
+    };
+
+    CalibrationLogEntry* reserve();
+    void publish(CalibrationLogEntry* entry);
+    void format(const CalibrationLogEntry& entry, char* buffer, size_t size) const;
+
+    static void setArg(CalibrationLogEntry& entry, ArgType type, uintptr_t raw);
+    static void pack(CalibrationLogEntry& entry, int value) { setArg(entry, ARG_INT, (uintptr_t)value); }
+    static void pack(CalibrationLogEntry& entry, long value) { setArg(entry, ARG_INT, (uintptr_t)value); }
+    static void pack(CalibrationLogEntry& entry, unsigned value) { setArg(entry, ARG_UINT, (uintptr_t)value); }
+    static void pack(CalibrationLogEntry& entry, unsigned long value) { setArg(entry, ARG_UINT, (uintptr_t)value); }
+    static void pack(CalibrationLogEntry& entry, double value);
+    static void pack(CalibrationLogEntry& entry, const char* value) {
+        setArg(entry, ARG_STRING, (uintptr_t)(value ? value : "(null)"));
+    }
+    static void pack(CalibrationLogEntry& entry, LogText value);
+
+    CalibrationLogEntry* _entries;
+    uint32_t _mask;
+    std::atomic<uint32_t> _head;
+    std::atomic<uint32_t> _tail;
+    std::atomic<uint32_t> _dropped;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "CalibrationMetrics.h"
+
+// Label values for the error counters, indexed by -CalibrationError
+static const char* const ERROR_LABELS[CalibrationMetrics::ERROR_CODES] = {
+    "ok",
+    "not_initialized",
+    "invalid_param",
+    "write_error",
+    "read_error",
+    "memory_error",
+    "encryption_error",
+    "not_found"
+};
+
+void CalibrationMetrics::reset() {
+    nvsReads.store(0, std::memory_order_relaxed);
+    nvsWrites.store(0, std::memory_order_relaxed);
+    bytesWritten.store(0, std::memory_order_relaxed);
+    encryptOps.store(0, std::memory_order_relaxed);
+    decryptOps.store(0, std::memory_order_relaxed);
+    for (uint8_t i = 0; i < ERROR_CODES; i++) {
+        errors[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+uint32_t CalibrationMetrics::errorCount(int error) const {
+    int index = -error;
+    if (index < 0 || index >= ERROR_CODES) return 0;
+    return errors[index].load(std::memory_order_relaxed);
+}
+
+void CalibrationMetrics::writeTo(Print& output, MetricsFormat format, const char* namespaceName) const {
+    const char* ns = namespaceName ? namespaceName : "";
+    const struct {
+        const char* name;
+        const std::atomic<uint32_t>& value;
+    } counters[] = {
+        {"nvs_reads", nvsReads},
+        {"nvs_writes", nvsWrites},
+        {"bytes_written", bytesWritten},
+        {"encrypt_ops", encryptOps},
+        {"decrypt_ops", decryptOps}
+    };
+
+    if (format == METRICS_JSON) {
+        output.printf("{\"namespace\":\"%s\"", ns);
+        for (const auto& counter : counters) {
+            output.printf(",\"%s\":%lu", counter.name,
+                          (unsigned long)counter.value.load(std::memory_order_relaxed));
+        }
+        output.print(",\"errors\":{");
+        for (uint8_t i = 1; i < ERROR_CODES; i++) {
+            output.printf("%s\"%s\":%lu", i > 1 ? "," : "", ERROR_LABELS[i],
+                          (unsigned long)errors[i].load(std::memory_order_relaxed));
+        }
+        output.println("}}");
+        return;
+    }
+
+    for (const auto& counter : counters) {
+        output.printf("# TYPE calibration_%s_total counter\n", counter.name);
+        output.printf("calibration_%s_total{namespace=\"%s\"} %lu\n", counter.name, ns,
+                      (unsigned long)counter.value.load(std::memory_order_relaxed));
+    }
+    output.print("# TYPE calibration_errors_total counter\n");
+    for (uint8_t i = 1; i < ERROR_CODES; i++) {
+        output.printf("calibration_errors_total{namespace=\"%s\",code=\"%s\"} %lu\n", ns,
+                      ERROR_LABELS[i], (unsigned long)errors[i].load(std::memory_order_relaxed));
+    }
+}
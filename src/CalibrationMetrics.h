@@ -0,0 +1,40 @@
+#ifndef CALIBRATION_METRICS_H
+#define CALIBRATION_METRICS_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Set to 0 to compile out all counter updates
+#ifndef CALIBRATION_ENABLE_METRICS
+#define CALIBRATION_ENABLE_METRICS 1
+#endif
+
+// Exposition formats for CalibrationMetrics::writeTo
+enum MetricsFormat {
+    METRICS_PROMETHEUS = 0,
+    METRICS_JSON = 1
+};
+
+// Monotonic operation counters. Updates are relaxed atomic increments, so
+// they are safe to bump from any task and cheap on the hot path.
+struct CalibrationMetrics {
+    // One slot per CalibrationError code, indexed by -error
+    static const uint8_t ERROR_CODES = 8;
+
+    std::atomic<uint32_t> nvsReads;
+    std::atomic<uint32_t> nvsWrites;
+    std::atomic<uint32_t> bytesWritten;
+    std::atomic<uint32_t> encryptOps;
+    std::atomic<uint32_t> decryptOps;
+    std::atomic<uint32_t> errors[ERROR_CODES];
+
+    CalibrationMetrics() { reset(); }
+
+    void reset();
+    uint32_t errorCount(int error) const;
+
+    // Serializes all counters; namespaceName is used as a label
+    void writeTo(Print& output, MetricsFormat format, const char* namespaceName) const;
+};
+
+#endif
@@ -0,0 +1,256 @@
+#include "CalibrationPipeline.h"
+
+SyntheticSource::SyntheticSource(uint8_t channels, uint32_t sampleRateHz) :
+    _channels(channels == 0 ? 1 : (channels > CALIBRATION_PIPELINE_CHANNELS ? CALIBRATION_PIPELINE_CHANNELS : channels)),
+    _next(0),
+    _sampleRateHz(sampleRateHz ? sampleRateHz : 1),
+    _frame(0),
+    _spikeInterval(0) {
+    for (uint8_t i = 0; i < CALIBRATION_PIPELINE_CHANNELS; i++) {
+        _offset[i] = 0.0f;
+        _amplitude[i] = 0.0f;
+        _frequency[i] = 0.0f;
+    }
+}
+
+void SyntheticSource::setSignal(uint8_t channel, float offset, float amplitude, float frequencyHz) {
+    if (channel >= CALIBRATION_PIPELINE_CHANNELS) {
+        return;
+    }
+    _offset[channel] = offset;
+    _amplitude[channel] = amplitude;
+    _frequency[channel] = frequencyHz;
+}
+
+size_t SyntheticSource::read(RawSample* samples, size_t maxSamples) {
+    if (!samples) {
+        return 0;
+    }
+    for (size_t i = 0; i < maxSamples; i++) {
+        const uint8_t c = _next;
+        float value = _offset[c];
+        if (_amplitude[c] != 0.0f) {
+            float t = (float)_frame / _sampleRateHz;
+            value += _amplitude[c] * sinf(2.0f * PI * _frequency[c] * t);
+        }
+        if (_spikeInterval && (_frame + 1) % _spikeInterval == 0) {
+            value = 4095.0f;
+        }
+        samples[i].value = value <= 0.0f ? 0 : (value >= 4095.0f ? 4095 : (uint16_t)(value + 0.5f));
+        samples[i].channel = c;
+        if (++_next >= _channels) {
+            _next = 0;
+            _frame++;
+        }
+    }
+    return maxSamples;
+}
+
+#if CALIBRATION_HAS_CONTINUOUS_ADC
+
+// Result layout differs between ADC generations
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define CAL_ADC_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define CAL_ADC_CHANNEL(result) ((result)->type1.channel)
+#define CAL_ADC_DATA(result) ((result)->type1.data)
+#else
+#define CAL_ADC_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define CAL_ADC_CHANNEL(result) ((result)->type2.channel)
+#define CAL_ADC_DATA(result) ((result)->type2.data)
+#endif
+
+ContinuousAdcSource::ContinuousAdcSource() : _handle(nullptr) {
+    memset(_channelIndex, -1, sizeof(_channelIndex));
+}
+
+ContinuousAdcSource::~ContinuousAdcSource() {
+    end();
+}
+
+bool ContinuousAdcSource::begin(const uint8_t* pins, uint8_t count, uint32_t sampleRateHz) {
+    if (!pins || count == 0 || count > CALIBRATION_PIPELINE_CHANNELS || count > SOC_ADC_PATT_LEN_MAX) {
+        return false;
+    }
+    end();
+
+    adc_digi_pattern_config_t pattern[SOC_ADC_PATT_LEN_MAX];
+    memset(pattern, 0, sizeof(pattern));
+    memset(_channelIndex, -1, sizeof(_channelIndex));
+    for (uint8_t i = 0; i < count; i++) {
+        adc_unit_t unit;
+        adc_channel_t channel;
+        if (adc_continuous_io_to_channel(pins[i], &unit, &channel) != ESP_OK || unit != ADC_UNIT_1) {
+            return false;
+        }
+        pattern[i].atten = ADC_ATTEN_DB_12;
+        pattern[i].channel = channel;
+        pattern[i].unit = ADC_UNIT_1;
+        pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+        _channelIndex[channel] = i;
+    }
+
+    adc_continuous_handle_cfg_t handleConfig;
+    memset(&handleConfig, 0, sizeof(handleConfig));
+    handleConfig.max_store_buf_size = 4 * FRAME_BYTES;
+    handleConfig.conv_frame_size = FRAME_BYTES;
+    if (adc_continuous_new_handle(&handleConfig, &_handle) != ESP_OK) {
+        _handle = nullptr;
+        return false;
+    }
+
+    adc_continuous_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.pattern_num = count;
+    config.adc_pattern = pattern;
+    config.sample_freq_hz = sampleRateHz;
+    config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    config.format = CAL_ADC_FORMAT;
+    if (adc_continuous_config(_handle, &config) != ESP_OK || adc_continuous_start(_handle) != ESP_OK) {
+        end();
+        return false;
+    }
+    return true;
+}
+
+void ContinuousAdcSource::end() {
+    if (_handle) {
+        adc_continuous_stop(_handle);
+        adc_continuous_deinit(_handle);
+        _handle = nullptr;
+    }
+}
+
+size_t ContinuousAdcSource::read(RawSample* samples, size_t maxSamples) {
+    if (!_handle || !samples) {
+        return 0;
+    }
+    size_t wanted = maxSamples * SOC_ADC_DIGI_RESULT_BYTES;
+    if (wanted > FRAME_BYTES) {
+        wanted = FRAME_BYTES;
+    }
+    uint32_t length = 0;
+    if (adc_continuous_read(_handle, _frame, wanted, &length, 0) != ESP_OK) {
+        return 0;
+    }
+
+    size_t count = 0;
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES) {
+        const adc_digi_output_data_t* result = (const adc_digi_output_data_t*)&_frame[i];
+        uint32_t channel = CAL_ADC_CHANNEL(result);
+        if (channel >= SOC_ADC_MAX_CHANNEL_NUM || _channelIndex[channel] < 0) {
+            continue;
+        }
+        samples[count].value = CAL_ADC_DATA(result);
+        samples[count].channel = _channelIndex[channel];
+        count++;
+    }
+    return count;
+}
+
+#endif
+
+CalibrationPipeline::CalibrationPipeline(SampleSource& source) : _source(source) {
+    for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+        _transforms[i] = nullptr;
+    }
+    start();
+}
+
+bool CalibrationPipeline::attachChannel(uint8_t channel, const CalibrationTransform& transform) {
+    if (channel >= MAX_CHANNELS) {
+        return false;
+    }
+    _transforms[channel] = &transform;
+    return true;
+}
+
+void CalibrationPipeline::detachChannel(uint8_t channel) {
+    if (channel < MAX_CHANNELS) {
+        _transforms[channel] = nullptr;
+        _fill[channel] = 0;
+    }
+}
+
+void CalibrationPipeline::start() {
+    memset(_fill, 0, sizeof(_fill));
+    memset(_emitted, 0, sizeof(_emitted));
+    _head = 0;
+    _tail = 0;
+    _dropped = 0;
+    _unmapped = 0;
+}
+
+size_t CalibrationPipeline::process() {
+    RawSample samples[BLOCK_SIZE];
+    size_t count = _source.read(samples, BLOCK_SIZE);
+
+    // Demultiplex into per-channel staging; full blocks go out immediately
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t channel = samples[i].channel;
+        if (channel >= MAX_CHANNELS || !_transforms[channel]) {
+            _unmapped++;
+            continue;
+        }
+        _staging[channel][_fill[channel]++] = samples[i].value;
+        if (_fill[channel] == BLOCK_SIZE) {
+            emit(channel);
+        }
+    }
+    return count;
+}
+
+void CalibrationPipeline::flush() {
+    for (uint8_t channel = 0; channel < MAX_CHANNELS; channel++) {
+        if (_fill[channel] && _transforms[channel]) {
+            emit(channel);
+        }
+    }
+}
+
+void CalibrationPipeline::emit(uint8_t channel) {
+    const uint16_t count = _fill[channel];
+    _fill[channel] = 0;
+    const uint32_t first = _emitted[channel];
+    _emitted[channel] += count;
+
+    const uint32_t tail = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+    if (_head - tail >= DEPTH) {
+        _dropped++;
+        return;
+    }
+    CalibratedBlock& block = _ring[_head % DEPTH];
+    block.channel = channel;
+    block.count = count;
+    block.firstSample = first;
+    _transforms[channel]->applyBatch(_staging[channel], block.values, count);
+    __atomic_store_n(&_head, _head + 1, __ATOMIC_RELEASE);
+}
+
+const CalibratedBlock* CalibrationPipeline::peek() const {
+    const uint32_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+    return head != _tail ? &_ring[_tail % DEPTH] : nullptr;
+}
+
+void CalibrationPipeline::release() {
+    const uint32_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+    if (head != _tail) {
+        __atomic_store_n(&_tail, _tail + 1, __ATOMIC_RELEASE);
+    }
+}
+
+bool CalibrationPipeline::read(CalibratedBlock& block) {
+    const CalibratedBlock* oldest = peek();
+    if (!oldest) {
+        return false;
+    }
+    block.channel = oldest->channel;
+    block.count = oldest->count;
+    block.firstSample = oldest->firstSample;
+    memcpy(block.values, oldest->values, oldest->count * sizeof(float));
+    release();
+    return true;
+}
+
+size_t CalibrationPipeline::available() const {
+    return __atomic_load_n(&_head, __ATOMIC_ACQUIRE) - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+}
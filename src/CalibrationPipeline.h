@@ -0,0 +1,186 @@
+#ifndef CALIBRATION_PIPELINE_H
+#define CALIBRATION_PIPELINE_H
+
+#include <Arduino.h>
+#include "CalibrationTransform.h"
+
+// Channels a pipeline can demultiplex
+#ifndef CALIBRATION_PIPELINE_CHANNELS
+#define CALIBRATION_PIPELINE_CHANNELS 8
+#endif
+
+// Samples per calibrated block
+#ifndef CALIBRATION_PIPELINE_BLOCK
+#define CALIBRATION_PIPELINE_BLOCK 64
+#endif
+
+// Blocks the ring buffer holds before the producer starts dropping
+#ifndef CALIBRATION_PIPELINE_DEPTH
+#define CALIBRATION_PIPELINE_DEPTH 8
+#endif
+
+#if defined(ESP32) && defined(__has_include)
+#if __has_include(<esp_adc/adc_continuous.h>)
+#include <esp_adc/adc_continuous.h>
+#define CALIBRATION_HAS_CONTINUOUS_ADC 1
+#endif
+#endif
+
+#ifndef CALIBRATION_HAS_CONTINUOUS_ADC
+#define CALIBRATION_HAS_CONTINUOUS_ADC 0
+#endif
+
+// One conversion result tagged with the pipeline channel it belongs to
+struct RawSample {
+    uint16_t value;
+    uint8_t channel;
+};
+
+// Produces raw samples in blocks. read() must not block; it returns what
+// is available, up to maxSamples.
+class SampleSource {
+public:
+    virtual ~SampleSource() {}
+    virtual size_t read(RawSample* samples, size_t maxSamples) = 0;
+};
+
+// Deterministic test signal for the unit tests and for bench checks
+// without the continuous ADC driver: channel c reads offset + amplitude *
+// sin(2 pi f t), sampled round-robin at sampleRateHz per channel and
+// clamped to 12 bits. read() returns as many samples as asked without
+// waiting; time advances with the sample count, so a task polling it must
+// pace itself.
+class SyntheticSource : public SampleSource {
+public:
+    explicit SyntheticSource(uint8_t channels = 1, uint32_t sampleRateHz = 1000);
+
+    void setSignal(uint8_t channel, float offset, float amplitude = 0.0f, float frequencyHz = 0.0f);
+    // Every interval-th sample of a channel reads full scale, to exercise
+    // outlier handling downstream (0 disables)
+    void setSpikeInterval(uint32_t interval) { _spikeInterval = interval; }
+    void reset() { _frame = 0; _next = 0; }
+
+    size_t read(RawSample* samples, size_t maxSamples) override;
+
+private:
+    uint8_t _channels;
+    uint8_t _next;
+    uint32_t _sampleRateHz;
+    uint32_t _frame;
+    uint32_t _spikeInterval;
+    float _offset[CALIBRATION_PIPELINE_CHANNELS];
+    float _amplitude[CALIBRATION_PIPELINE_CHANNELS];
+    float _frequency[CALIBRATION_PIPELINE_CHANNELS];
+};
+
+#if CALIBRATION_HAS_CONTINUOUS_ADC
+// ADC1 in continuous (DMA) mode through the ESP-IDF driver. The hardware
+// scans the given pins round-robin at sampleRateHz total; pipeline channel
+// i is pins[i]. Only ADC1 pins are accepted, since ADC2 is shared with
+// Wi-Fi.
+//
+//   const uint8_t pins[] = {34, 35};
+//   ContinuousAdcSource adc;
+//   adc.begin(pins, 2, 40000);      // 20 kHz per channel
+class ContinuousAdcSource : public SampleSource {
+public:
+    ContinuousAdcSource();
+    ~ContinuousAdcSource();
+
+    bool begin(const uint8_t* pins, uint8_t count, uint32_t sampleRateHz);
+    void end();
+
+    size_t read(RawSample* samples, size_t maxSamples) override;
+
+private:
+    ContinuousAdcSource(const ContinuousAdcSource&);
+    ContinuousAdcSource& operator=(const ContinuousAdcSource&);
+
+    static const size_t FRAME_BYTES = CALIBRATION_PIPELINE_BLOCK * SOC_ADC_DIGI_RESULT_BYTES;
+
+    adc_continuous_handle_t _handle;
+    int8_t _channelIndex[SOC_ADC_MAX_CHANNEL_NUM];   // ADC channel -> pipeline channel
+    uint8_t _frame[FRAME_BYTES];
+};
+#endif
+
+// A block of calibrated samples from one channel. firstSample counts that
+// channel's samples since start(), so consumers can place blocks in time;
+// a gap means blocks were dropped.
+struct CalibratedBlock {
+    uint8_t channel;
+    uint16_t count;
+    uint32_t firstSample;
+    float values[CALIBRATION_PIPELINE_BLOCK];
+};
+
+// Pulls raw blocks from a SampleSource, sorts them by channel and, once a
+// channel has a full block, calibrates it with one applyBatch() call
+// straight into a ring buffer slot. Consumers take whole blocks out of the
+// ring, so nothing runs per sample except the demultiplexing loop.
+//
+//   CalibrationTransform pot;
+//   calib.loadTransform("pot_model", pot);
+//   CalibrationPipeline pipeline(adc);
+//   pipeline.attachChannel(0, pot);
+//
+//   void loop() {
+//       pipeline.process();
+//       while (const CalibratedBlock* block = pipeline.peek()) {
+//           consume(block->values, block->count);
+//           pipeline.release();
+//       }
+//   }
+//
+// process() and the consumer may run on different cores: the ring is a
+// single-producer, single-consumer queue with acquire/release indices.
+// When it is full, new blocks are dropped and counted.
+class CalibrationPipeline {
+public:
+    static const uint8_t MAX_CHANNELS = CALIBRATION_PIPELINE_CHANNELS;
+    static const uint16_t BLOCK_SIZE = CALIBRATION_PIPELINE_BLOCK;
+    static const uint8_t DEPTH = CALIBRATION_PIPELINE_DEPTH;
+
+    explicit CalibrationPipeline(SampleSource& source);
+
+    // The transform must outlive the pipeline; its changes apply to the
+    // next block
+    bool attachChannel(uint8_t channel, const CalibrationTransform& transform);
+    void detachChannel(uint8_t channel);
+    // Clears staged samples, the ring and all counters
+    void start();
+
+    // Reads one source block and emits every channel block it completes;
+    // returns the number of raw samples consumed
+    size_t process();
+    // Emits partially filled channel blocks
+    void flush();
+
+    // Oldest calibrated block, or nullptr; valid until release()
+    const CalibratedBlock* peek() const;
+    void release();
+    // Copies the oldest block out and releases it
+    bool read(CalibratedBlock& block);
+    size_t available() const;
+
+    uint32_t droppedBlocks() const { return _dropped; }
+    // Samples for channels with no transform attached
+    uint32_t unmappedSamples() const { return _unmapped; }
+
+private:
+    void emit(uint8_t channel);
+
+    SampleSource& _source;
+    const CalibrationTransform* _transforms[MAX_CHANNELS];
+    int16_t _staging[MAX_CHANNELS][BLOCK_SIZE];
+    uint16_t _fill[MAX_CHANNELS];
+    uint32_t _emitted[MAX_CHANNELS];   // samples already sent per channel
+
+    CalibratedBlock _ring[DEPTH];
+    uint32_t _head;     // written by the producer only
+    uint32_t _tail;     // written by the consumer only
+    uint32_t _dropped;
+    uint32_t _unmapped;
+};
+
+#endif
@@ -0,0 +1,248 @@
+#include "CalibrationProfiler.h"
+
+const char* getOperationName(CalibrationOp op) {
+    switch(op) {
+        case CAL_OP_GET: return "get";
+        case CAL_OP_SET: return "set";
+        case CAL_OP_BATCH_COMMIT: return "batch_commit";
+        case CAL_OP_IMPORT: return "import";
+        case CAL_OP_EXPORT: return "export";
+        case CAL_OP_ENCRYPT: return "encrypt";
+        case CAL_OP_DECRYPT: return "decrypt";
+        case CAL_OP_BEGIN: return "begin";
+        case CAL_OP_REMOVE: return "remove";
+        case CAL_OP_CLEAR: return "clear";
+        case CAL_OP_NVS_READ: return "nvs_read";
+        case CAL_OP_JSON_PARSE: return "json_parse";
+        case CAL_OP_JSON_SERIALIZE: return "json_serialize";
+        case CAL_OP_KEY_DERIVE: return "key_derive";
+        default: return "unknown";
+    }
+}
+
+void LatencyHistogram::reset() {
+    memset(buckets, 0, sizeof(buckets));
+    count = 0;
+    minUs = UINT32_MAX;
+    maxUs = 0;
+    totalUs = 0;
+}
+
+void LatencyHistogram::record(uint32_t us) {
+    uint8_t bucket = us ? 32 - __builtin_clz(us) : 0;
+    if (bucket >= BUCKETS) {
+        bucket = BUCKETS - 1;
+    }
+    buckets[bucket]++;
+    count++;
+    totalUs += us;
+    if (us < minUs) minUs = us;
+    if (us > maxUs) maxUs = us;
+}
+
+uint32_t LatencyHistogram::bucketUpperBound(uint8_t bucket) {
+    if (bucket == 0) return 0;
+    if (bucket >= BUCKETS - 1) return UINT32_MAX;
+    return (1UL << bucket) - 1;
+}
+
+uint32_t LatencyHistogram::percentileUs(float percentile) const {
+    if (count == 0) return 0;
+
+    uint32_t target = (uint32_t)ceilf(count * percentile / 100.0f);
+    if (target == 0) target = 1;
+
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= target) {
+            uint32_t bound = bucketUpperBound(i);
+            return bound < maxUs ? bound : maxUs;
+        }
+    }
+    return maxUs;
+}
+
+void LatencyHistogram::printTo(Print& output, const char* label) const {
+    if (count == 0) {
+        output.printf("%-13s n=0\n", label);
+        return;
+    }
+    output.printf("%-13s n=%lu min=%luus avg=%luus p50<=%luus p99<=%luus max=%luus\n",
+                  label, (unsigned long)count, (unsigned long)minUs,
+                  (unsigned long)averageUs(), (unsigned long)percentileUs(50),
+                  (unsigned long)percentileUs(99), (unsigned long)maxUs);
+}
+
+ChromeTraceWriter::ChromeTraceWriter(Print& output, uint32_t threadId) :
+    _output(output),
+    _threadId(threadId),
+    _open(false) {
+}
+
+void ChromeTraceWriter::finish() {
+    if (_open) {
+        _output.println("]");
+        _open = false;
+    }
+}
+
+void ChromeTraceWriter::hook(void* context, TracePhase phase, CalibrationOp op, const char* detail) {
+    if (context) {
+        static_cast<ChromeTraceWriter*>(context)->write(phase, op, detail);
+    }
+}
+
+// Keys are caller strings, so quote them as JSON: escape quote and backslash,
+// and write control characters as \u00XX
+static void printJsonString(Print& output, const char* text) {
+    output.print('"');
+    for (; *text; text++) {
+        const char c = *text;
+        if (c == '"' || c == '\\') {
+            output.print('\\');
+            output.print(c);
+        } else if ((uint8_t)c < 0x20) {
+            output.printf("\\u%04x", (unsigned)c);
+        } else {
+            output.print(c);
+        }
+    }
+    output.print('"');
+}
+
+void ChromeTraceWriter::write(TracePhase phase, CalibrationOp op, const char* detail) {
+    _output.print(_open ? ",\n" : "[\n");
+    _open = true;
+    _output.printf("{\"name\":\"%s\",\"cat\":\"calibration\",\"ph\":\"%c\",\"ts\":%lu,\"pid\":1,\"tid\":%lu",
+                   getOperationName(op), phase == TRACE_BEGIN ? 'B' : 'E',
+                   (unsigned long)micros(), (unsigned long)_threadId);
+    if (detail && phase == TRACE_BEGIN) {
+        _output.print(",\"args\":{\"key\":");
+        printJsonString(_output, detail);
+        _output.print("}");
+    }
+    _output.print("}");
+}
+
+BootProfiler::BootProfiler() {
+    reset();
+}
+
+void BootProfiler::reset() {
+    _depth = 0;
+    _overflow = 0;
+    _count = 0;
+    _dropped = 0;
+    _firstStartUs = 0;
+    _lastEndUs = 0;
+    _ended = false;
+}
+
+void BootProfiler::hook(void* context, TracePhase phase, CalibrationOp op, const char* detail) {
+    BootProfiler* profiler = static_cast<BootProfiler*>(context);
+    if (!profiler) return;
+    if (phase == TRACE_BEGIN) {
+        profiler->onBegin(op, detail);
+    } else {
+        profiler->onEnd();
+    }
+}
+
+void BootProfiler::onBegin(CalibrationOp op, const char* detail) {
+    uint32_t now = micros();
+    if (_count == 0 && _dropped == 0) {
+        _firstStartUs = now;
+    }
+    if (_depth >= MAX_DEPTH) {
+        // Counted so the matching onEnd() does not pop an outer scope
+        _overflow++;
+        _dropped++;
+        return;
+    }
+
+    int8_t index = -1;
+    if (_count < MAX_RECORDS) {
+        index = _count++;
+        Record& record = _records[index];
+        record.op = op;
+        record.depth = _depth;
+        record.startUs = now;
+        record.totalUs = 0;
+        record.selfUs = 0;
+        strncpy(record.detail, detail ? detail : "", sizeof(record.detail) - 1);
+        record.detail[sizeof(record.detail) - 1] = '\0';
+    } else {
+        _dropped++;
+    }
+    // Scopes past MAX_RECORDS are not recorded but still take a stack slot,
+    // so their end pops the slot their begin pushed
+    _stack[_depth] = index;
+    _childUs[_depth] = 0;
+    _depth++;
+}
+
+void BootProfiler::onEnd() {
+    // Innermost scopes end first, so overflowed ones close before any
+    // scope on the stack
+    if (_overflow > 0) {
+        _overflow--;
+        return;
+    }
+    if (_depth == 0) return;
+    uint32_t now = micros();
+    _depth--;
+    int8_t index = _stack[_depth];
+    if (index < 0) return;
+
+    Record& record = _records[index];
+    record.totalUs = now - record.startUs;
+    record.selfUs = record.totalUs > _childUs[_depth] ? record.totalUs - _childUs[_depth] : 0;
+    if (_depth > 0) {
+        _childUs[_depth - 1] += record.totalUs;
+    }
+    _lastEndUs = now;
+    _ended = true;
+}
+
+void BootProfiler::printReport(Print& output, size_t maxRecords) const {
+    output.printf("Boot profile: %lu records, %luus elapsed", (unsigned long)_count,
+                  (unsigned long)elapsedUs());
+    if (_dropped) {
+        output.printf(" (%lu dropped)", (unsigned long)_dropped);
+    }
+    output.println();
+
+    // Exclusive time per operation type
+    uint32_t opSelf[CAL_OP_COUNT] = {0};
+    uint16_t opCalls[CAL_OP_COUNT] = {0};
+    for (uint8_t i = 0; i < _count; i++) {
+        opSelf[_records[i].op] += _records[i].selfUs;
+        opCalls[_records[i].op]++;
+    }
+    output.println("By operation (self time):");
+    for (int op = 0; op < CAL_OP_COUNT; op++) {
+        if (opCalls[op]) {
+            output.printf("  %-15s %4u calls %8luus\n", getOperationName((CalibrationOp)op),
+                          opCalls[op], (unsigned long)opSelf[op]);
+        }
+    }
+
+    // Insertion sort of record indices by inclusive time, slowest first
+    uint8_t order[MAX_RECORDS];
+    for (uint8_t i = 0; i < _count; i++) {
+        uint8_t j = i;
+        while (j > 0 && _records[order[j - 1]].totalUs < _records[i].totalUs) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    output.println("Slowest records (total / self):");
+    for (uint8_t i = 0; i < _count && i < maxRecords; i++) {
+        const Record& record = _records[order[i]];
+        output.printf("  %8luus %8luus  %-15s %s\n", (unsigned long)record.totalUs,
+                      (unsigned long)record.selfUs, getOperationName(record.op), record.detail);
+    }
+}
@@ -0,0 +1,178 @@
+#ifndef CALIBRATION_PROFILER_H
+#define CALIBRATION_PROFILER_H
+
+#include <Arduino.h>
+
+// Set to 1 to compile latency instrumentation into CalibrationLib. When 0
+// the timing scopes expand to nothing and no histogram memory is reserved.
+#ifndef CALIBRATION_ENABLE_PROFILING
+#define CALIBRATION_ENABLE_PROFILING 0
+#endif
+
+// Set to 0 to compile out trace hook calls. When enabled but no hook is
+// installed, each traced operation costs one pointer test.
+#ifndef CALIBRATION_ENABLE_TRACING
+#define CALIBRATION_ENABLE_TRACING 1
+#endif
+
+// Instrumented operations and the internal phases nested inside them
+enum CalibrationOp {
+    CAL_OP_GET = 0,
+    CAL_OP_SET,
+    CAL_OP_BATCH_COMMIT,
+    CAL_OP_IMPORT,
+    CAL_OP_EXPORT,
+    CAL_OP_ENCRYPT,
+    CAL_OP_DECRYPT,
+    CAL_OP_BEGIN,
+    CAL_OP_REMOVE,
+    CAL_OP_CLEAR,
+    CAL_OP_NVS_READ,
+    CAL_OP_JSON_PARSE,
+    CAL_OP_JSON_SERIALIZE,
+    CAL_OP_KEY_DERIVE,
+    CAL_OP_COUNT
+};
+
+enum TracePhase {
+    TRACE_BEGIN = 0,
+    TRACE_END = 1
+};
+
+// Called on entry to and exit from every traced operation. detail is the key
+// or namespace involved (may be nullptr) and is only valid during the call.
+typedef void (*CalibrationTraceHook)(void* context, TracePhase phase, CalibrationOp op, const char* detail);
+
+const char* getOperationName(CalibrationOp op);
+
+// Log2-bucketed latency histogram in microseconds. Bucket 0 holds 0us,
+// bucket i holds [2^(i-1), 2^i) and the last bucket everything above.
+struct LatencyHistogram {
+    static const uint8_t BUCKETS = 20;
+
+    uint32_t buckets[BUCKETS];
+    uint32_t count;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint64_t totalUs;
+
+    LatencyHistogram() { reset(); }
+
+    void reset();
+    void record(uint32_t us);
+    uint32_t averageUs() const { return count ? (uint32_t)(totalUs / count) : 0; }
+    // Upper bound of the bucket containing the given percentile (0-100)
+    uint32_t percentileUs(float percentile) const;
+    void printTo(Print& output, const char* label) const;
+
+    static uint32_t bucketUpperBound(uint8_t bucket);
+};
+
+// Records the lifetime of the scope into a histogram
+class LatencyScope {
+public:
+    explicit LatencyScope(LatencyHistogram& histogram) : _histogram(histogram), _start(micros()) {}
+    ~LatencyScope() { _histogram.record(micros() - _start); }
+
+private:
+    LatencyHistogram& _histogram;
+    uint32_t _start;
+};
+
+// Emits begin/end trace events for the lifetime of the scope
+class TraceScope {
+public:
+    TraceScope(CalibrationTraceHook hook, void* context, CalibrationOp op, const char* detail) :
+        _hook(hook), _context(context), _op(op), _detail(detail) {
+        if (_hook) _hook(_context, TRACE_BEGIN, _op, _detail);
+    }
+    ~TraceScope() {
+        if (_hook) _hook(_context, TRACE_END, _op, _detail);
+    }
+
+private:
+    CalibrationTraceHook _hook;
+    void* _context;
+    CalibrationOp _op;
+    const char* _detail;
+};
+
+// Trace hook that writes Chrome trace event JSON (chrome://tracing,
+// Perfetto) to a Print, such as Serial or a file on the host.
+//
+//   ChromeTraceWriter trace(Serial);
+//   calib.setTraceHook(ChromeTraceWriter::hook, &trace);
+//   ... traced work ...
+//   trace.finish();
+class ChromeTraceWriter {
+public:
+    explicit ChromeTraceWriter(Print& output, uint32_t threadId = 1);
+
+    // Closes the JSON array; events after this start a new one
+    void finish();
+
+    static void hook(void* context, TracePhase phase, CalibrationOp op, const char* detail);
+
+private:
+    void write(TracePhase phase, CalibrationOp op, const char* detail);
+
+    Print& _output;
+    uint32_t _threadId;
+    bool _open;
+};
+
+// Trace hook that records a timed tree of operations during startup and
+// prints them sorted by cost, to show which keys are worth packing or caching.
+//
+//   BootProfiler profiler;
+//   calib.setTraceHook(BootProfiler::hook, &profiler);
+//   calib.begin("sensors");
+//   loadCalibration();
+//   calib.setTraceHook(nullptr);
+//   profiler.printReport(Serial);
+class BootProfiler {
+public:
+    static const uint8_t MAX_RECORDS = 64;
+    static const uint8_t MAX_DEPTH = 8;
+
+    struct Record {
+        CalibrationOp op;
+        char detail[16];
+        uint8_t depth;
+        uint32_t startUs;
+        uint32_t totalUs;   // inclusive time
+        uint32_t selfUs;    // excluding nested phases
+    };
+
+    BootProfiler();
+
+    void reset();
+    size_t recordCount() const { return _count; }
+    const Record& record(size_t index) const { return _records[index]; }
+    uint32_t droppedRecords() const { return _dropped; }
+    // Time from the first recorded begin to the last recorded end; 0 until
+    // a recorded scope has ended
+    uint32_t elapsedUs() const { return _ended ? _lastEndUs - _firstStartUs : 0; }
+
+    // Per-operation totals followed by individual records, slowest first
+    void printReport(Print& output, size_t maxRecords = 20) const;
+
+    static void hook(void* context, TracePhase phase, CalibrationOp op, const char* detail);
+
+private:
+    void onBegin(CalibrationOp op, const char* detail);
+    void onEnd();
+
+    Record _records[MAX_RECORDS];
+    int8_t _stack[MAX_DEPTH];
+    uint32_t _childUs[MAX_DEPTH];
+    uint8_t _depth;
+    uint16_t _overflow;   // open scopes nested past MAX_DEPTH, not on the stack
+    uint8_t _count;
+    uint32_t _dropped;
+    uint32_t _firstStartUs;
+    uint32_t _lastEndUs;
+    bool _ended;          // _lastEndUs is valid
+};
+
+#endif
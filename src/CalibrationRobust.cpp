@@ -0,0 +1,266 @@
+#include "CalibrationRobust.h"
+
+// Consistency constant that makes the MAD estimate the standard deviation
+// of normally distributed samples
+static const float MAD_SCALE = 1.4826f;
+
+struct IdentityKey {
+    float operator()(float value) const { return value; }
+};
+
+struct DistanceKey {
+    float center;
+    float operator()(float value) const { return fabsf(value - center); }
+};
+
+// Quickselect ordered by key(value), so the MAD can be found by distance
+// from the median without a second buffer
+template <typename Key>
+static void selectBy(float* values, size_t count, size_t k, Key key) {
+    long lo = 0;
+    long hi = (long)count - 1;
+    while (hi > lo) {
+        // Median of three as pivot; also leaves sentinels at both ends
+        long mid = lo + (hi - lo) / 2;
+        if (key(values[mid]) < key(values[lo])) { float t = values[mid]; values[mid] = values[lo]; values[lo] = t; }
+        if (key(values[hi]) < key(values[lo])) { float t = values[hi]; values[hi] = values[lo]; values[lo] = t; }
+        if (key(values[hi]) < key(values[mid])) { float t = values[hi]; values[hi] = values[mid]; values[mid] = t; }
+        const float pivot = key(values[mid]);
+
+        long i = lo;
+        long j = hi;
+        while (i <= j) {
+            while (key(values[i]) < pivot) i++;
+            while (key(values[j]) > pivot) j--;
+            if (i <= j) {
+                float t = values[i];
+                values[i] = values[j];
+                values[j] = t;
+                i++;
+                j--;
+            }
+        }
+        // [lo, j] <= pivot, (j, i) == pivot, [i, hi] >= pivot
+        if ((long)k <= j) {
+            hi = j;
+        } else if ((long)k >= i) {
+            lo = i;
+        } else {
+            return;
+        }
+    }
+}
+
+float selectNth(float* values, size_t count, size_t k) {
+    if (!values || k >= count) {
+        return 0.0f;
+    }
+    selectBy(values, count, k, IdentityKey());
+    return values[k];
+}
+
+// Middle value by key; for an even count the mean of the two middle ones.
+// After selecting the upper middle, the lower one is the largest before it.
+template <typename Key>
+static float middleBy(float* values, size_t count, Key key) {
+    size_t upper = count / 2;
+    selectBy(values, count, upper, key);
+    float high = key(values[upper]);
+    if (count & 1) {
+        return high;
+    }
+    float low = key(values[0]);
+    for (size_t i = 1; i < upper; i++) {
+        float v = key(values[i]);
+        if (v > low) low = v;
+    }
+    return 0.5f * (low + high);
+}
+
+RobustSampleBuffer::RobustSampleBuffer(float* storage, size_t capacity) :
+    _values(storage),
+    _capacity(capacity),
+    _count(0),
+    _trim(0.1f),
+    _threshold(3.0f) {
+}
+
+bool RobustSampleBuffer::add(float value) {
+    if (_count >= _capacity) {
+        return false;
+    }
+    _values[_count++] = value;
+    return true;
+}
+
+void RobustSampleBuffer::setTrimFraction(float fraction) {
+    _trim = fraction < 0.0f ? 0.0f : (fraction > 0.5f ? 0.5f : fraction);
+}
+
+float RobustSampleBuffer::mean() const {
+    if (_count == 0) {
+        return 0.0f;
+    }
+    double sum = 0.0;
+    for (size_t i = 0; i < _count; i++) {
+        sum += _values[i];
+    }
+    return (float)(sum / _count);
+}
+
+float RobustSampleBuffer::median() {
+    return _count ? middleBy(_values, _count, IdentityKey()) : 0.0f;
+}
+
+float RobustSampleBuffer::trimmedMean() {
+    size_t drop = (size_t)(_count * _trim);
+    if (_count == 0 || 2 * drop >= _count) {
+        return median();
+    }
+    // Two selections bracket the kept range; its order inside is irrelevant
+    size_t kept = _count - 2 * drop;
+    selectBy(_values, _count, drop, IdentityKey());
+    selectBy(_values + drop, _count - drop, kept - 1, IdentityKey());
+    double sum = 0.0;
+    for (size_t i = drop; i < drop + kept; i++) {
+        sum += _values[i];
+    }
+    return (float)(sum / kept);
+}
+
+float RobustSampleBuffer::mad() {
+    if (_count == 0) {
+        return 0.0f;
+    }
+    DistanceKey distance = {median()};
+    return MAD_SCALE * middleBy(_values, _count, distance);
+}
+
+float RobustSampleBuffer::madMean(size_t* kept) {
+    if (_count == 0) {
+        if (kept) *kept = 0;
+        return 0.0f;
+    }
+    float center = median();
+    DistanceKey distance = {center};
+    float limit = _threshold * MAD_SCALE * middleBy(_values, _count, distance);
+
+    double sum = 0.0;
+    size_t n = 0;
+    for (size_t i = 0; i < _count; i++) {
+        if (fabsf(_values[i] - center) <= limit) {
+            sum += _values[i];
+            n++;
+        }
+    }
+    if (kept) *kept = n;
+    return n ? (float)(sum / n) : center;
+}
+
+float RobustSampleBuffer::value(RobustMode mode) {
+    switch (mode) {
+        case ROBUST_MEDIAN: return median();
+        case ROBUST_TRIMMED_MEAN: return trimmedMean();
+        case ROBUST_MAD_MEAN: return madMean();
+        default: return mean();
+    }
+}
+
+StreamingQuantile::StreamingQuantile(float quantile) :
+    _quantile(quantile < 0.0f ? 0.0f : (quantile > 1.0f ? 1.0f : quantile)) {
+    reset();
+}
+
+void StreamingQuantile::reset() {
+    const float p = _quantile;
+    _count = 0;
+    for (uint8_t i = 0; i < 5; i++) {
+        _heights[i] = 0.0f;
+        _positions[i] = i + 1;
+    }
+    _desired[0] = 1.0f;
+    _desired[1] = 1.0f + 2.0f * p;
+    _desired[2] = 1.0f + 4.0f * p;
+    _desired[3] = 3.0f + 2.0f * p;
+    _desired[4] = 5.0f;
+    _increments[0] = 0.0f;
+    _increments[1] = p / 2.0f;
+    _increments[2] = p;
+    _increments[3] = (1.0f + p) / 2.0f;
+    _increments[4] = 1.0f;
+}
+
+void StreamingQuantile::add(float value) {
+    if (_count < 5) {
+        // Insertion sort of the first five samples, which seed the markers
+        uint8_t i = _count++;
+        while (i > 0 && _heights[i - 1] > value) {
+            _heights[i] = _heights[i - 1];
+            i--;
+        }
+        _heights[i] = value;
+        return;
+    }
+    _count++;
+
+    // Cell containing the sample, stretching the end markers if needed
+    uint8_t cell;
+    if (value < _heights[0]) {
+        _heights[0] = value;
+        cell = 0;
+    } else if (value >= _heights[4]) {
+        _heights[4] = value;
+        cell = 3;
+    } else {
+        cell = 0;
+        while (value >= _heights[cell + 1]) {
+            cell++;
+        }
+    }
+    for (uint8_t i = cell + 1; i < 5; i++) {
+        _positions[i]++;
+    }
+    for (uint8_t i = 0; i < 5; i++) {
+        _desired[i] += _increments[i];
+    }
+
+    // Move the middle markers one step towards their desired positions
+    for (uint8_t i = 1; i < 4; i++) {
+        float drift = _desired[i] - _positions[i];
+        if ((drift >= 1.0f && _positions[i + 1] - _positions[i] > 1) ||
+            (drift <= -1.0f && _positions[i - 1] - _positions[i] < -1)) {
+            int8_t direction = drift > 0.0f ? 1 : -1;
+            float height = parabolic(i, direction);
+            if (!(_heights[i - 1] < height && height < _heights[i + 1])) {
+                height = linear(i, direction);
+            }
+            _heights[i] = height;
+            _positions[i] += direction;
+        }
+    }
+}
+
+float StreamingQuantile::parabolic(uint8_t i, int8_t direction) const {
+    const float d = direction;
+    const float below = (float)(_positions[i] - _positions[i - 1]);
+    const float above = (float)(_positions[i + 1] - _positions[i]);
+    return _heights[i] + d / (below + above) *
+           ((below + d) * (_heights[i + 1] - _heights[i]) / above +
+            (above - d) * (_heights[i] - _heights[i - 1]) / below);
+}
+
+float StreamingQuantile::linear(uint8_t i, int8_t direction) const {
+    return _heights[i] + direction * (_heights[i + direction] - _heights[i]) /
+           (float)(_positions[i + direction] - _positions[i]);
+}
+
+float StreamingQuantile::value() const {
+    if (_count == 0) {
+        return 0.0f;
+    }
+    if (_count < 5) {
+        // Still exact: the first samples are kept sorted
+        return _heights[(uint8_t)lroundf(_quantile * (_count - 1))];
+    }
+    return _heights[2];
+}
@@ -0,0 +1,114 @@
+#ifndef CALIBRATION_ROBUST_H
+#define CALIBRATION_ROBUST_H
+
+#include <Arduino.h>
+
+// How a RobustSampleBuffer reduces its samples to one value
+enum RobustMode : uint8_t {
+    ROBUST_MEAN = 0,            // plain mean, for comparison
+    ROBUST_MEDIAN = 1,
+    ROBUST_TRIMMED_MEAN = 2,    // mean after dropping the lowest and highest share
+    ROBUST_MAD_MEAN = 3         // mean of samples within k scaled MADs of the median
+};
+
+// Partially reorders values so values[k] is the k-th smallest, everything
+// before it is no larger and everything after no smaller, and returns it.
+// Hoare quickselect with median-of-three pivots: O(n) on average.
+float selectNth(float* values, size_t count, size_t k);
+
+// Fixed-capacity sample buffer with outlier-resistant estimators. The
+// estimators select in place, reordering the stored samples, so they are
+// not const; the set of samples is unchanged. A single ADC spike moves
+// the median and MAD mean by at most one rank instead of dragging the mean.
+//
+// Use RobustAggregator<N> below, which supplies the storage.
+class RobustSampleBuffer {
+public:
+    RobustSampleBuffer(float* storage, size_t capacity);
+
+    void reset() { _count = 0; }
+    // Samples past the capacity are dropped; returns false for those
+    bool add(float value);
+
+    size_t count() const { return _count; }
+    size_t capacity() const { return _capacity; }
+    bool isFull() const { return _count == _capacity; }
+
+    // Share dropped from each end by the trimmed mean (default 0.1)
+    void setTrimFraction(float fraction);
+    // Samples further than this many scaled MADs from the median are
+    // rejected by the MAD mean (default 3)
+    void setRejectThreshold(float threshold) { _threshold = threshold; }
+
+    float mean() const;
+    float median();
+    float trimmedMean();
+    // Median absolute deviation scaled by 1.4826, a standard deviation
+    // estimate that ignores outliers
+    float mad();
+    // kept receives the number of samples that passed the MAD test
+    float madMean(size_t* kept = nullptr);
+
+    float value(RobustMode mode);
+    // Correction that moves the aggregate onto the reference value
+    float offsetTo(float reference, RobustMode mode = ROBUST_MEDIAN) { return reference - value(mode); }
+
+private:
+    float* _values;
+    size_t _capacity;
+    size_t _count;
+    float _trim;
+    float _threshold;
+};
+
+//   RobustAggregator<64> zero;
+//   void loop() {
+//       zero.add(analogRead(34));
+//       if (zero.isFull()) {
+//           calib.storeOffset("zero_offset", zero, 0.0f, ROBUST_MEDIAN);
+//           zero.reset();
+//       }
+//   }
+template <size_t N>
+class RobustAggregator : public RobustSampleBuffer {
+public:
+    RobustAggregator() : RobustSampleBuffer(_storage, N) {}
+
+private:
+    RobustAggregator(const RobustAggregator&);
+    RobustAggregator& operator=(const RobustAggregator&);
+
+    float _storage[N];
+};
+
+// Streaming quantile estimate (the P-square algorithm of Jain and
+// Chlamtac) in constant memory: five markers are nudged towards their
+// ideal positions as samples arrive, with parabolic interpolation. Use it
+// where the sample count is too large to buffer; the estimate converges to
+// within the input noise after a few hundred samples.
+class StreamingQuantile {
+public:
+    // 0.5 tracks the median
+    explicit StreamingQuantile(float quantile = 0.5f);
+
+    void reset();
+    void add(float value);
+
+    uint32_t count() const { return _count; }
+    float quantile() const { return _quantile; }
+    float value() const;
+    float offsetTo(float reference) const { return reference - value(); }
+
+private:
+    float parabolic(uint8_t i, int8_t direction) const;
+    float linear(uint8_t i, int8_t direction) const;
+
+    float _quantile;
+    uint32_t _count;
+    float _heights[5];
+    int32_t _positions[5];
+    float _desired[5];
+    float _increments[5];
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include "CalibrationTable.h"
+
+// Serialized layout: magic, version, channel count (16-bit little endian),
+// then the offsets, scales and flags arrays back to back, so loading is
+// three copies
+static const uint8_t TABLE_MAGIC = 'M';
+static const uint8_t TABLE_VERSION = 1;
+
+CalibrationTable::CalibrationTable(uint16_t channels) : _channels(0) {
+    for (uint16_t i = 0; i < MAX_CHANNELS; i++) {
+        resetChannel(i);
+    }
+    setChannelCount(channels);
+}
+
+void CalibrationTable::resetChannel(uint16_t channel) {
+    _offsets[channel] = 0.0f;
+    _scales[channel] = 1.0f;
+    _flags[channel] = TABLE_CHANNEL_ENABLED;
+    _units[channel] = nullptr;
+    prepare(channel);
+}
+
+// value = (raw - offset) * scale = raw * gain + bias, one multiply-add
+void CalibrationTable::prepare(uint16_t channel) {
+    if (_flags[channel] & TABLE_CHANNEL_ENABLED) {
+        _gain[channel] = _scales[channel];
+        _bias[channel] = -_offsets[channel] * _scales[channel];
+    } else {
+        _gain[channel] = 0.0f;
+        _bias[channel] = 0.0f;
+    }
+}
+
+bool CalibrationTable::setChannelCount(uint16_t channels) {
+    if (channels > MAX_CHANNELS) {
+        return false;
+    }
+    for (uint16_t i = channels; i < _channels; i++) {
+        resetChannel(i);
+    }
+    _channels = channels;
+    return true;
+}
+
+bool CalibrationTable::setChannel(uint16_t channel, float offset, float scale, uint8_t flags) {
+    if (channel >= _channels) {
+        return false;
+    }
+    _offsets[channel] = offset;
+    _scales[channel] = scale;
+    _flags[channel] = flags;
+    prepare(channel);
+    return true;
+}
+
+void CalibrationTable::setEnabled(uint16_t channel, bool enabled) {
+    if (channel >= _channels) {
+        return;
+    }
+    if (enabled) {
+        _flags[channel] |= TABLE_CHANNEL_ENABLED;
+    } else {
+        _flags[channel] &= ~TABLE_CHANNEL_ENABLED;
+    }
+    prepare(channel);
+}
+
+void CalibrationTable::setUnit(uint16_t channel, const char* unit) {
+    if (channel < _channels) {
+        _units[channel] = unit;
+    }
+}
+
+// One frame against the gain/bias arrays. Channels are independent, so
+// the loop runs across them, unrolled by four since the ESP32 FPU is scalar.
+template <typename T>
+static void frameKernel(const T* raw, float* out, const float* gain, const float* bias, uint16_t count) {
+    uint16_t c = 0;
+    for (; c + 4 <= count; c += 4) {
+        float x0 = raw[c], x1 = raw[c + 1], x2 = raw[c + 2], x3 = raw[c + 3];
+        out[c] = x0 * gain[c] + bias[c];
+        out[c + 1] = x1 * gain[c + 1] + bias[c + 1];
+        out[c + 2] = x2 * gain[c + 2] + bias[c + 2];
+        out[c + 3] = x3 * gain[c + 3] + bias[c + 3];
+    }
+    for (; c < count; c++) {
+        out[c] = raw[c] * gain[c] + bias[c];
+    }
+}
+
+void CalibrationTable::applyFrame(const int16_t* frame, float* out) const {
+    if (frame && out) {
+        frameKernel(frame, out, _gain, _bias, _channels);
+    }
+}
+
+void CalibrationTable::applyFrame(const float* frame, float* out) const {
+    if (frame && out) {
+        frameKernel(frame, out, _gain, _bias, _channels);
+    }
+}
+
+void CalibrationTable::applyFrames(const int16_t* frames, float* out, size_t frameCount) const {
+    if (!frames || !out) {
+        return;
+    }
+    for (size_t f = 0; f < frameCount; f++) {
+        frameKernel(frames + f * _channels, out + f * _channels, _gain, _bias, _channels);
+    }
+}
+
+void CalibrationTable::applyFrames(const float* frames, float* out, size_t frameCount) const {
+    if (!frames || !out) {
+        return;
+    }
+    for (size_t f = 0; f < frameCount; f++) {
+        frameKernel(frames + f * _channels, out + f * _channels, _gain, _bias, _channels);
+    }
+}
+
+size_t CalibrationTable::serialize(uint8_t* buffer, size_t size) const {
+    const size_t total = serializedSize();
+    if (!buffer || size < total) {
+        return 0;
+    }
+    buffer[0] = TABLE_MAGIC;
+    buffer[1] = TABLE_VERSION;
+    buffer[2] = _channels & 0xFF;
+    buffer[3] = _channels >> 8;
+    uint8_t* p = buffer + 4;
+    memcpy(p, _offsets, _channels * sizeof(float));
+    p += _channels * sizeof(float);
+    memcpy(p, _scales, _channels * sizeof(float));
+    p += _channels * sizeof(float);
+    memcpy(p, _flags, _channels);
+    return total;
+}
+
+bool CalibrationTable::deserialize(const uint8_t* buffer, size_t size) {
+    if (!buffer || size < 4 || buffer[0] != TABLE_MAGIC || buffer[1] != TABLE_VERSION) {
+        return false;
+    }
+    const uint16_t channels = buffer[2] | (buffer[3] << 8);
+    if (channels > MAX_CHANNELS || size != 4 + channels * (2 * sizeof(float) + 1)) {
+        return false;
+    }
+    setChannelCount(channels);
+    const uint8_t* p = buffer + 4;
+    memcpy(_offsets, p, channels * sizeof(float));
+    p += channels * sizeof(float);
+    memcpy(_scales, p, channels * sizeof(float));
+    p += channels * sizeof(float);
+    memcpy(_flags, p, channels);
+    for (uint16_t i = 0; i < channels; i++) {
+        prepare(i);
+    }
+    return true;
+}
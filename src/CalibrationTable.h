@@ -0,0 +1,94 @@
+#ifndef CALIBRATION_TABLE_H
+#define CALIBRATION_TABLE_H
+
+#include <Arduino.h>
+
+// Channels one CalibrationTable can hold
+#ifndef CALIBRATION_TABLE_CHANNELS
+#define CALIBRATION_TABLE_CHANNELS 64
+#endif
+
+// Per-channel flags stored with the table
+enum TableChannelFlags : uint8_t {
+    TABLE_CHANNEL_ENABLED = 0x01,      // disabled channels read 0
+    TABLE_CHANNEL_CALIBRATED = 0x02    // offset and scale were measured, not defaults
+};
+
+// Offset/scale calibration for many channels held as parallel arrays, so
+// applying it to an interleaved frame (ch0, ch1, ..., chN-1, ch0, ...)
+// walks the coefficients in order and vectorizes across channels:
+//
+//   value = (raw - offset) * scale
+//
+// Flags are folded into a gain/bias pair per channel when a channel
+// changes, so the apply loop has no branches. Units and other metadata sit
+// in a separate array that the apply loop never touches, and they are not
+// stored; keep them in code.
+//
+//   CalibrationTable table(32);
+//   calib.loadCalibrationTable("adc_table", table);
+//   int16_t frame[32];
+//   float values[32];
+//   table.applyFrame(frame, values);
+class CalibrationTable {
+public:
+    static const uint16_t MAX_CHANNELS = CALIBRATION_TABLE_CHANNELS;
+    static const size_t MAX_SERIALIZED_SIZE = 4 + MAX_CHANNELS * (2 * sizeof(float) + 1);
+
+    // Every channel starts enabled with offset 0 and scale 1; more than
+    // MAX_CHANNELS leaves the table empty
+    explicit CalibrationTable(uint16_t channels = 0);
+
+    // Channels past the new count are reset; returns false above MAX_CHANNELS
+    bool setChannelCount(uint16_t channels);
+    uint16_t channelCount() const { return _channels; }
+
+    bool setChannel(uint16_t channel, float offset, float scale,
+                    uint8_t flags = TABLE_CHANNEL_ENABLED | TABLE_CHANNEL_CALIBRATED);
+    void setEnabled(uint16_t channel, bool enabled);
+    void setUnit(uint16_t channel, const char* unit);
+
+    float offset(uint16_t channel) const { return channel < _channels ? _offsets[channel] : 0.0f; }
+    float scale(uint16_t channel) const { return channel < _channels ? _scales[channel] : 0.0f; }
+    uint8_t flags(uint16_t channel) const { return channel < _channels ? _flags[channel] : 0; }
+    const char* unit(uint16_t channel) const { return channel < _channels && _units[channel] ? _units[channel] : ""; }
+
+    // Parallel arrays of channelCount() entries
+    const float* offsets() const { return _offsets; }
+    const float* scales() const { return _scales; }
+    const uint8_t* flagArray() const { return _flags; }
+
+    // channel must be below channelCount()
+    inline float apply(uint16_t channel, float raw) const {
+        return raw * _gain[channel] + _bias[channel];
+    }
+
+    // One frame of channelCount() samples
+    void applyFrame(const int16_t* frame, float* out) const;
+    void applyFrame(const float* frame, float* out) const;
+    // frameCount consecutive frames; out has the same interleaved layout
+    void applyFrames(const int16_t* frames, float* out, size_t frameCount) const;
+    void applyFrames(const float* frames, float* out, size_t frameCount) const;
+
+    // Offsets, scales and flags as one blob; units are not included
+    size_t serializedSize() const { return 4 + _channels * (2 * sizeof(float) + 1); }
+    size_t serialize(uint8_t* buffer, size_t size) const;
+    bool deserialize(const uint8_t* buffer, size_t size);
+
+private:
+    void resetChannel(uint16_t channel);
+    void prepare(uint16_t channel);
+
+    uint16_t _channels;
+    // Hot: read by the apply loops
+    float _gain[MAX_CHANNELS];
+    float _bias[MAX_CHANNELS];
+    // Stored form
+    float _offsets[MAX_CHANNELS];
+    float _scales[MAX_CHANNELS];
+    uint8_t _flags[MAX_CHANNELS];
+    // Cold metadata
+    const char* _units[MAX_CHANNELS];
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "CalibrationThermal.h"
+
+// Serialized layout: magic, version, count, reserved, then temperatures,
+// offsets and scales as float arrays
+static const uint8_t THERMAL_MAGIC = 'H';
+static const uint8_t THERMAL_VERSION = 1;
+static const size_t THERMAL_HEADER_SIZE = 4;
+
+ThermalCalibration::ThermalCalibration() {
+    clear();
+}
+
+void ThermalCalibration::clear() {
+    _count = 0;
+    _segment = 0;
+    memset(_temperatures, 0, sizeof(_temperatures));
+    memset(_offsets, 0, sizeof(_offsets));
+    memset(_offsetSlopes, 0, sizeof(_offsetSlopes));
+    memset(_scaleSlopes, 0, sizeof(_scaleSlopes));
+    for (uint8_t i = 0; i < MAX_POINTS; i++) {
+        _scales[i] = 1.0f;
+    }
+}
+
+bool ThermalCalibration::setTable(const float* temperatures, const float* offsets, const float* scales, uint8_t count) {
+    if (!temperatures || !offsets || count == 0 || count > MAX_POINTS) {
+        return false;
+    }
+    for (uint8_t i = 1; i < count; i++) {
+        if (!(temperatures[i] > temperatures[i - 1])) {
+            return false;
+        }
+    }
+
+    clear();
+    _count = count;
+    memcpy(_temperatures, temperatures, count * sizeof(float));
+    memcpy(_offsets, offsets, count * sizeof(float));
+    if (scales) {
+        memcpy(_scales, scales, count * sizeof(float));
+    }
+    updateSlopes();
+    return true;
+}
+
+void ThermalCalibration::updateSlopes() {
+    for (uint8_t i = 0; i + 1 < _count; i++) {
+        float span = _temperatures[i + 1] - _temperatures[i];
+        _offsetSlopes[i] = (_offsets[i + 1] - _offsets[i]) / span;
+        _scaleSlopes[i] = (_scales[i + 1] - _scales[i]) / span;
+    }
+}
+
+uint8_t ThermalCalibration::search(float temperature) const {
+    const float* base = _temperatures;
+    uint8_t length = _count - 1;
+    while (length > 1) {
+        uint8_t half = length / 2;
+        base = (base[half] <= temperature) ? base + half : base;
+        length -= half;
+    }
+    return base - _temperatures;
+}
+
+void ThermalCalibration::coefficients(float temperature, float& scale, float& offset) const {
+    if (_count < 2) {
+        scale = _scales[0];
+        offset = _offsets[0];
+        return;
+    }
+    uint8_t i = segment(temperature);
+    float dt = clampToTable(temperature) - _temperatures[i];
+    scale = _scales[i] + dt * _scaleSlopes[i];
+    offset = _offsets[i] + dt * _offsetSlopes[i];
+}
+
+void ThermalCalibration::applyBatch(const float* raw, float* out, size_t count, float temperature) const {
+    if (!raw || !out) {
+        return;
+    }
+    // One lookup for the whole block, then a plain multiply-add loop
+    float scale, offset;
+    coefficients(temperature, scale, offset);
+    for (size_t i = 0; i < count; i++) {
+        out[i] = raw[i] * scale + offset;
+    }
+}
+
+size_t ThermalCalibration::serialize(uint8_t* buffer, size_t size) const {
+    size_t needed = serializedSize();
+    if (!buffer || size < needed) {
+        return 0;
+    }
+    buffer[0] = THERMAL_MAGIC;
+    buffer[1] = THERMAL_VERSION;
+    buffer[2] = _count;
+    buffer[3] = 0;
+    size_t block = _count * sizeof(float);
+    uint8_t* payload = buffer + THERMAL_HEADER_SIZE;
+    memcpy(payload, _temperatures, block);
+    memcpy(payload + block, _offsets, block);
+    memcpy(payload + 2 * block, _scales, block);
+    return needed;
+}
+
+bool ThermalCalibration::deserialize(const uint8_t* buffer, size_t size) {
+    if (!buffer || size < THERMAL_HEADER_SIZE ||
+        buffer[0] != THERMAL_MAGIC || buffer[1] != THERMAL_VERSION) {
+        return false;
+    }
+    uint8_t count = buffer[2];
+    if (count > MAX_POINTS || size < THERMAL_HEADER_SIZE + 3 * count * sizeof(float)) {
+        return false;
+    }
+    if (count == 0) {
+        clear();
+        return true;
+    }
+
+    float values[3 * MAX_POINTS];
+    memcpy(values, buffer + THERMAL_HEADER_SIZE, 3 * count * sizeof(float));
+    return setTable(values, values + count, values + 2 * count, count);
+}
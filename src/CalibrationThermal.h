@@ -0,0 +1,102 @@
+#ifndef CALIBRATION_THERMAL_H
+#define CALIBRATION_THERMAL_H
+
+#include <Arduino.h>
+
+// Largest number of temperature points in a compensation table
+#ifndef CALIBRATION_MAX_THERMAL_POINTS
+#define CALIBRATION_MAX_THERMAL_POINTS 8
+#endif
+
+// Temperature-compensated linear calibration for one channel:
+//
+//   corrected = raw * scale(T) + offset(T)
+//
+// scale and offset are measured at a few temperatures and interpolated
+// linearly in between; outside the table the end values are held. The
+// segment used by the last lookup is cached, so at slowly changing
+// temperatures each lookup is one range check and two multiply-adds.
+//
+//   const float temps[]   = {-10, 25, 60};
+//   const float offsets[] = {1.8f, 0.0f, -2.1f};
+//   const float scales[]  = {0.998f, 1.0f, 1.003f};
+//   ThermalCalibration pressure;
+//   pressure.setTable(temps, offsets, scales, 3);
+//   calib.storeThermalCalibration("pres_thermal", pressure);
+//   ...
+//   float hPa = pressure.apply(rawPressure, bme.readTemperature());
+//
+// The cache makes lookups non-reentrant: give each task its own copy.
+class ThermalCalibration {
+public:
+    static const uint8_t MAX_POINTS = CALIBRATION_MAX_THERMAL_POINTS;
+    // Header plus temperature, offset and scale arrays
+    static const size_t MAX_SERIALIZED_SIZE = 4 + 3 * MAX_POINTS * sizeof(float);
+
+    ThermalCalibration();
+
+    // No compensation: scale 1, offset 0 at every temperature
+    void clear();
+    // temperatures must be strictly increasing; scales may be nullptr for
+    // an offset-only table
+    bool setTable(const float* temperatures, const float* offsets, const float* scales, uint8_t count);
+
+    uint8_t size() const { return _count; }
+    float temperature(uint8_t index) const { return index < _count ? _temperatures[index] : 0.0f; }
+    float offsetAt(uint8_t index) const { return index < _count ? _offsets[index] : 0.0f; }
+    float scaleAt(uint8_t index) const { return index < _count ? _scales[index] : 1.0f; }
+
+    // Interpolated coefficients at the given temperature
+    void coefficients(float temperature, float& scale, float& offset) const;
+
+    inline float apply(float raw, float temperature) const {
+        if (_count < 2) {
+            return _count ? raw * _scales[0] + _offsets[0] : raw;
+        }
+        uint8_t i = segment(temperature);
+        float dt = clampToTable(temperature) - _temperatures[i];
+        return raw * (_scales[i] + dt * _scaleSlopes[i]) + (_offsets[i] + dt * _offsetSlopes[i]);
+    }
+
+    // Corrects a block of samples taken at one temperature; out may alias raw
+    void applyBatch(const float* raw, float* out, size_t count, float temperature) const;
+
+    size_t serializedSize() const { return 4 + 3 * _count * sizeof(float); }
+    size_t serialize(uint8_t* buffer, size_t size) const;
+    bool deserialize(const uint8_t* buffer, size_t size);
+
+private:
+    inline float clampToTable(float temperature) const {
+        if (temperature < _temperatures[0]) return _temperatures[0];
+        if (temperature > _temperatures[_count - 1]) return _temperatures[_count - 1];
+        return temperature;
+    }
+
+    // Segment containing temperature, trying the cached one and its
+    // neighbours before falling back to a binary search
+    inline uint8_t segment(float temperature) const {
+        uint8_t i = _segment;
+        if (temperature >= _temperatures[i]) {
+            if (i + 2 >= _count || temperature < _temperatures[i + 1]) return i;
+            if (i + 3 >= _count || temperature < _temperatures[i + 2]) return _segment = i + 1;
+        } else if (i == 0) {
+            return 0;
+        } else if (temperature >= _temperatures[i - 1]) {
+            return _segment = i - 1;
+        }
+        return _segment = search(temperature);
+    }
+
+    uint8_t search(float temperature) const;
+    void updateSlopes();
+
+    uint8_t _count;
+    mutable uint8_t _segment;
+    float _temperatures[MAX_POINTS];
+    float _offsets[MAX_POINTS];
+    float _scales[MAX_POINTS];
+    float _offsetSlopes[MAX_POINTS];    // per segment, per degree
+    float _scaleSlopes[MAX_POINTS];
+};
+
+#endif
@@ -0,0 +1,309 @@
+#include "CalibrationTransform.h"
+
+static_assert(CalibrationTransform::MAX_POINTS >= CalibrationTransform::MAX_DEGREE + 1,
+              "CALIBRATION_MAX_TABLE_POINTS must hold all polynomial coefficients");
+static_assert(2 * CalibrationTransform::MAX_POINTS >= CalibrationTransform::MAX_DEGREE + 3,
+              "MAX_SERIALIZED_SIZE must hold a normalized polynomial");
+
+// Serialized layout: magic, format version, type, count, then float payload.
+// Version 2 appends center and inverseRange to a normalized polynomial;
+// everything else is still written as version 1 for older firmware.
+static const uint8_t TRANSFORM_MAGIC = 'T';
+static const uint8_t TRANSFORM_VERSION = 1;
+static const uint8_t TRANSFORM_VERSION_NORMALIZED = 2;
+static const size_t TRANSFORM_HEADER_SIZE = 4;
+
+// Revisions come from one counter shared by all transforms, so a model
+// assigned from another transform (or a factory) never repeats the
+// revision a cache recorded
+static uint32_t nextRevision = 0;
+
+CalibrationTransform::CalibrationTransform() : _revision(0) {
+    setIdentity();
+}
+
+CalibrationTransform CalibrationTransform::linear(float scale, float offset) {
+    CalibrationTransform transform;
+    transform.setLinear(scale, offset);
+    return transform;
+}
+
+CalibrationTransform CalibrationTransform::polynomial(const float* coefficients, uint8_t degree,
+                                                      float center, float inverseRange) {
+    CalibrationTransform transform;
+    transform.setPolynomial(coefficients, degree, center, inverseRange);
+    return transform;
+}
+
+CalibrationTransform CalibrationTransform::piecewise(const float* raw, const float* values, uint8_t count) {
+    CalibrationTransform transform;
+    transform.setPiecewise(raw, values, count);
+    return transform;
+}
+
+void CalibrationTransform::setIdentity() {
+    // Every setter starts here, so this covers all coefficient changes
+    _revision = __atomic_add_fetch(&nextRevision, 1, __ATOMIC_RELAXED);
+    _type = TRANSFORM_IDENTITY;
+    _count = 0;
+    _center = 0.0f;
+    _inverseRange = 1.0f;
+    memset(_coefficients, 0, sizeof(_coefficients));
+    memset(_points, 0, sizeof(_points));
+    memset(_slopes, 0, sizeof(_slopes));
+}
+
+void CalibrationTransform::setLinear(float scale, float offset) {
+    setIdentity();
+    _type = TRANSFORM_LINEAR;
+    _count = 1;
+    _coefficients[0] = offset;
+    _coefficients[1] = scale;
+}
+
+bool CalibrationTransform::setPolynomial(const float* coefficients, uint8_t degree,
+                                         float center, float inverseRange) {
+    if (!coefficients || degree > MAX_DEGREE || !isfinite(center) ||
+        !isfinite(inverseRange) || inverseRange == 0.0f) {
+        return false;
+    }
+    // Trailing zero terms only cost multiplies
+    while (degree > 0 && coefficients[degree] == 0.0f) {
+        degree--;
+    }
+    if (degree <= 1) {
+        // c0 + c1 * (raw - center) * inverseRange as scale and offset
+        const double scale = degree == 1 ? (double)coefficients[1] * inverseRange : 0.0;
+        setLinear((float)scale, (float)(coefficients[0] - scale * center));
+        return true;
+    }
+
+    setIdentity();
+    _type = TRANSFORM_POLYNOMIAL;
+    _count = degree;
+    _center = center;
+    _inverseRange = inverseRange;
+    memcpy(_coefficients, coefficients, (degree + 1) * sizeof(float));
+    return true;
+}
+
+bool CalibrationTransform::setPiecewise(const float* raw, const float* values, uint8_t count) {
+    if (!raw || !values || count < 2 || count > MAX_POINTS) {
+        return false;
+    }
+    for (uint8_t i = 1; i < count; i++) {
+        if (!(raw[i] > raw[i - 1])) {
+            return false;
+        }
+    }
+
+    setIdentity();
+    _type = TRANSFORM_PIECEWISE;
+    _count = count;
+    memcpy(_points, raw, count * sizeof(float));
+    memcpy(_coefficients, values, count * sizeof(float));
+    for (uint8_t i = 0; i + 1 < count; i++) {
+        _slopes[i] = (values[i + 1] - values[i]) / (raw[i + 1] - raw[i]);
+    }
+    return true;
+}
+
+float CalibrationTransform::scale() const {
+    switch (_type) {
+        case TRANSFORM_LINEAR:
+            return _coefficients[1];
+        case TRANSFORM_POLYNOMIAL: {
+            // Slope at raw = 0, as for the other types
+            const float u = -_center * _inverseRange;
+            float slope = _count * _coefficients[_count];
+            for (int8_t i = _count - 1; i >= 1; i--) {
+                slope = slope * u + i * _coefficients[i];
+            }
+            return slope * _inverseRange;
+        }
+        case TRANSFORM_PIECEWISE:
+            return _slopes[0];
+        default:
+            return 1.0f;
+    }
+}
+
+float CalibrationTransform::offset() const {
+    return _type == TRANSFORM_IDENTITY ? 0.0f : apply(0.0f);
+}
+
+// Linear kernels return how many leading samples they handled; the scalar
+// tail in applyBatch finishes the rest. ESP32-S3 PIE instructions have no
+// float lanes, so the unrolled scalar loop is the fast path and lets the
+// compiler keep the FPU pipeline full.
+static size_t linearKernel(const int16_t* raw, float* out, size_t count, float scale, float offset) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float x0 = raw[i], x1 = raw[i + 1], x2 = raw[i + 2], x3 = raw[i + 3];
+        out[i] = x0 * scale + offset;
+        out[i + 1] = x1 * scale + offset;
+        out[i + 2] = x2 * scale + offset;
+        out[i + 3] = x3 * scale + offset;
+    }
+    return i;
+}
+
+static size_t linearKernel(const float* raw, float* out, size_t count, float scale, float offset) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float x0 = raw[i], x1 = raw[i + 1], x2 = raw[i + 2], x3 = raw[i + 3];
+        out[i] = x0 * scale + offset;
+        out[i + 1] = x1 * scale + offset;
+        out[i + 2] = x2 * scale + offset;
+        out[i + 3] = x3 * scale + offset;
+    }
+    return i;
+}
+
+// Horner's rule run coefficient by coefficient over a block, so the inner
+// loop has no dependency between samples and can be vectorized.
+template <typename T>
+static void polynomialKernel(const T* raw, float* out, size_t count, const float* coefficients, uint8_t degree,
+                             float center, float inverseRange) {
+    const size_t BLOCK = 32;
+    float x[BLOCK];
+    float y[BLOCK];
+    for (size_t start = 0; start < count; start += BLOCK) {
+        size_t length = count - start < BLOCK ? count - start : BLOCK;
+        for (size_t j = 0; j < length; j++) {
+            x[j] = (raw[start + j] - center) * inverseRange;
+            y[j] = coefficients[degree];
+        }
+        for (int8_t k = degree - 1; k >= 0; k--) {
+            const float c = coefficients[k];
+            for (size_t j = 0; j < length; j++) {
+                y[j] = y[j] * x[j] + c;
+            }
+        }
+        memcpy(out + start, y, length * sizeof(float));
+    }
+}
+
+void CalibrationTransform::applyBatch(const int16_t* raw, float* out, size_t count) const {
+    if (!raw || !out) {
+        return;
+    }
+    size_t i = 0;
+    if (_type == TRANSFORM_LINEAR) {
+        i = linearKernel(raw, out, count, _coefficients[1], _coefficients[0]);
+    } else if (_type == TRANSFORM_POLYNOMIAL) {
+        polynomialKernel(raw, out, count, _coefficients, _count, _center, _inverseRange);
+        return;
+    }
+    for (; i < count; i++) {
+        out[i] = apply(raw[i]);
+    }
+}
+
+void CalibrationTransform::applyBatch(const float* raw, float* out, size_t count) const {
+    if (!raw || !out) {
+        return;
+    }
+    size_t i = 0;
+    if (_type == TRANSFORM_LINEAR) {
+        i = linearKernel(raw, out, count, _coefficients[1], _coefficients[0]);
+    } else if (_type == TRANSFORM_POLYNOMIAL) {
+        polynomialKernel(raw, out, count, _coefficients, _count, _center, _inverseRange);
+        return;
+    }
+    for (; i < count; i++) {
+        out[i] = apply(raw[i]);
+    }
+}
+
+// Only polynomials with a domain need the version 2 layout
+static bool isNormalized(TransformType type, float center, float inverseRange) {
+    return type == TRANSFORM_POLYNOMIAL && (center != 0.0f || inverseRange != 1.0f);
+}
+
+size_t CalibrationTransform::serializedSize() const {
+    switch (_type) {
+        case TRANSFORM_LINEAR:
+            return TRANSFORM_HEADER_SIZE + 2 * sizeof(float);
+        case TRANSFORM_POLYNOMIAL:
+            return TRANSFORM_HEADER_SIZE + (_count + 1) * sizeof(float) +
+                   (isNormalized(_type, _center, _inverseRange) ? 2 * sizeof(float) : 0);
+        case TRANSFORM_PIECEWISE:
+            return TRANSFORM_HEADER_SIZE + 2 * _count * sizeof(float);
+        default:
+            return TRANSFORM_HEADER_SIZE;
+    }
+}
+
+size_t CalibrationTransform::serialize(uint8_t* buffer, size_t size) const {
+    size_t needed = serializedSize();
+    if (!buffer || size < needed) {
+        return 0;
+    }
+
+    const bool normalized = isNormalized(_type, _center, _inverseRange);
+    buffer[0] = TRANSFORM_MAGIC;
+    buffer[1] = normalized ? TRANSFORM_VERSION_NORMALIZED : TRANSFORM_VERSION;
+    buffer[2] = _type;
+    buffer[3] = _count;
+    uint8_t* payload = buffer + TRANSFORM_HEADER_SIZE;
+    switch (_type) {
+        case TRANSFORM_LINEAR:
+            memcpy(payload, _coefficients, 2 * sizeof(float));
+            break;
+        case TRANSFORM_POLYNOMIAL:
+            memcpy(payload, _coefficients, (_count + 1) * sizeof(float));
+            if (normalized) {
+                payload += (_count + 1) * sizeof(float);
+                memcpy(payload, &_center, sizeof(float));
+                memcpy(payload + sizeof(float), &_inverseRange, sizeof(float));
+            }
+            break;
+        case TRANSFORM_PIECEWISE:
+            memcpy(payload, _points, _count * sizeof(float));
+            memcpy(payload + _count * sizeof(float), _coefficients, _count * sizeof(float));
+            break;
+        default:
+            break;
+    }
+    return needed;
+}
+
+bool CalibrationTransform::deserialize(const uint8_t* buffer, size_t size) {
+    if (!buffer || size < TRANSFORM_HEADER_SIZE || buffer[0] != TRANSFORM_MAGIC ||
+        (buffer[1] != TRANSFORM_VERSION && buffer[1] != TRANSFORM_VERSION_NORMALIZED)) {
+        return false;
+    }
+
+    TransformType type = (TransformType)buffer[2];
+    uint8_t count = buffer[3];
+    const uint8_t* payload = buffer + TRANSFORM_HEADER_SIZE;
+    size_t payloadSize = size - TRANSFORM_HEADER_SIZE;
+    float values[2 * MAX_POINTS];
+
+    switch (type) {
+        case TRANSFORM_IDENTITY:
+            setIdentity();
+            return true;
+        case TRANSFORM_LINEAR:
+            if (payloadSize < 2 * sizeof(float)) return false;
+            memcpy(values, payload, 2 * sizeof(float));
+            setLinear(values[1], values[0]);
+            return true;
+        case TRANSFORM_POLYNOMIAL: {
+            const size_t terms = count + 1 + (buffer[1] == TRANSFORM_VERSION_NORMALIZED ? 2 : 0);
+            if (count > MAX_DEGREE || payloadSize < terms * sizeof(float)) return false;
+            memcpy(values, payload, terms * sizeof(float));
+            if (buffer[1] == TRANSFORM_VERSION_NORMALIZED) {
+                return setPolynomial(values, count, values[count + 1], values[count + 2]);
+            }
+            return setPolynomial(values, count);
+        }
+        case TRANSFORM_PIECEWISE:
+            if (count > MAX_POINTS || payloadSize < 2 * count * sizeof(float)) return false;
+            memcpy(values, payload, 2 * count * sizeof(float));
+            return setPiecewise(values, values + count, count);
+        default:
+            return false;
+    }
+}
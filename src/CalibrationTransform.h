@@ -0,0 +1,122 @@
+#ifndef CALIBRATION_TRANSFORM_H
+#define CALIBRATION_TRANSFORM_H
+
+#include <Arduino.h>
+
+// Highest polynomial degree a transform can hold
+#ifndef CALIBRATION_MAX_POLY_DEGREE
+#define CALIBRATION_MAX_POLY_DEGREE 5
+#endif
+
+// Largest number of breakpoints in a piecewise-linear table
+#ifndef CALIBRATION_MAX_TABLE_POINTS
+#define CALIBRATION_MAX_TABLE_POINTS 16
+#endif
+
+// Transform models
+enum TransformType : uint8_t {
+    TRANSFORM_IDENTITY = 0,
+    TRANSFORM_LINEAR = 1,       // y = raw * scale + offset
+    TRANSFORM_POLYNOMIAL = 2,   // y = c0 + c1*u + ... + cN*u^N, u = (raw - center) * inverseRange
+    TRANSFORM_PIECEWISE = 3     // linear interpolation between breakpoints
+};
+
+// Typed calibration model for one channel. Coefficients are prepared once
+// when the model is set or loaded, so apply() is a Horner loop or a
+// branchless table search followed by one multiply-add.
+class CalibrationTransform {
+public:
+    static const uint8_t MAX_DEGREE = CALIBRATION_MAX_POLY_DEGREE;
+    static const uint8_t MAX_POINTS = CALIBRATION_MAX_TABLE_POINTS;
+    // Header plus the largest payload (piecewise x and y arrays; a
+    // normalized polynomial is at most MAX_DEGREE + 3 floats)
+    static const size_t MAX_SERIALIZED_SIZE = 4 + 2 * MAX_POINTS * sizeof(float);
+
+    CalibrationTransform();
+
+    static CalibrationTransform linear(float scale, float offset);
+    static CalibrationTransform polynomial(const float* coefficients, uint8_t degree,
+                                           float center = 0.0f, float inverseRange = 1.0f);
+    static CalibrationTransform piecewise(const float* raw, const float* values, uint8_t count);
+
+    void setIdentity();
+    void setLinear(float scale, float offset);
+    // coefficients[i] multiplies u^i with u = (raw - center) * inverseRange.
+    // The defaults make u = raw; fitted models pass their domain so the
+    // terms stay small and float evaluation keeps its precision far from
+    // zero. Returns false if degree is too high or inverseRange is not
+    // finite and nonzero.
+    bool setPolynomial(const float* coefficients, uint8_t degree,
+                       float center = 0.0f, float inverseRange = 1.0f);
+    // raw must be strictly increasing; values outside are extrapolated
+    bool setPiecewise(const float* raw, const float* values, uint8_t count);
+
+    TransformType type() const { return _type; }
+    // Changes whenever the model is set or loaded, so caches can detect
+    // edits; unique across transforms, so it follows copies too
+    uint32_t revision() const { return _revision; }
+    // Polynomial degree (1 for linear) or number of table points
+    uint8_t size() const { return _count; }
+    float scale() const;
+    float offset() const;
+    float coefficient(uint8_t index) const { return index < MAX_POINTS ? _coefficients[index] : 0.0f; }
+    // Polynomial input normalization; 0 and 1 for every other type
+    float center() const { return _center; }
+    float inverseRange() const { return _inverseRange; }
+    float point(uint8_t index) const { return index < MAX_POINTS ? _points[index] : 0.0f; }
+
+    inline float apply(float raw) const {
+        switch (_type) {
+            case TRANSFORM_LINEAR:
+                return raw * _coefficients[1] + _coefficients[0];
+            case TRANSFORM_POLYNOMIAL: {
+                const float u = (raw - _center) * _inverseRange;
+                float y = _coefficients[_count];
+                for (int8_t i = _count - 1; i >= 0; i--) {
+                    y = y * u + _coefficients[i];
+                }
+                return y;
+            }
+            case TRANSFORM_PIECEWISE: {
+                uint8_t i = segment(raw);
+                return _coefficients[i] + (raw - _points[i]) * _slopes[i];
+            }
+            default:
+                return raw;
+        }
+    }
+
+    // Applies the transform to a block of samples. out may alias raw in the
+    // float overload. Linear blocks use SIMD kernels where available.
+    void applyBatch(const int16_t* raw, float* out, size_t count) const;
+    void applyBatch(const float* raw, float* out, size_t count) const;
+
+    // Compact binary form used for NVS storage
+    size_t serializedSize() const;
+    size_t serialize(uint8_t* buffer, size_t size) const;
+    bool deserialize(const uint8_t* buffer, size_t size);
+
+private:
+    // Index of the segment containing raw, clamped to the first/last one
+    inline uint8_t segment(float raw) const {
+        const float* base = _points;
+        uint8_t length = _count - 1;
+        while (length > 1) {
+            uint8_t half = length / 2;
+            base = (base[half] <= raw) ? base + half : base;
+            length -= half;
+        }
+        return base - _points;
+    }
+
+    TransformType _type;
+    uint8_t _count;
+    uint32_t _revision;
+    float _center;
+    float _inverseRange;
+    float _coefficients[MAX_POINTS];    // offset/scale, polynomial terms or table values
+    float _points[MAX_POINTS];          // piecewise breakpoints
+    float _slopes[MAX_POINTS];          // piecewise segment slopes
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include "CalibrationWorkflow.h"
+
+CalibrationWorkflow::CalibrationWorkflow(CalibrationLib& calibration, const char* channel,
+                                         WorkflowSampler sampler, void* context) :
+    _calibration(calibration),
+    _channel(channel),
+    _sampler(sampler),
+    _context(context),
+    _output(&Serial),
+    _steps(nullptr),
+    _stepCount(0),
+    _step(0),
+    _state(WORKFLOW_IDLE),
+    _confirmed(false),
+    _stateStartMs(0),
+    _lastSampleMs(0),
+    _sampleIntervalMs(10),
+    _maxResidual(0.0f),
+    _lastRaw(0.0f),
+    _error(CAL_OK),
+    _robust(nullptr),
+    _robustMode(ROBUST_MEDIAN),
+    _fitter(1) {
+    memset(&_fit, 0, sizeof(_fit));
+}
+
+const char* CalibrationWorkflow::getStateName(WorkflowState state) {
+    switch(state) {
+        case WORKFLOW_IDLE: return "idle";
+        case WORKFLOW_PROMPT: return "prompt";
+        case WORKFLOW_SETTLE: return "settle";
+        case WORKFLOW_SAMPLE: return "sample";
+        case WORKFLOW_COMPUTE: return "compute";
+        case WORKFLOW_COMMIT: return "commit";
+        case WORKFLOW_DONE: return "done";
+        case WORKFLOW_FAILED: return "failed";
+        default: return "unknown";
+    }
+}
+
+bool CalibrationWorkflow::setDegree(uint8_t degree) {
+    if (isActive()) {
+        return false;
+    }
+    return _fitter.setDegree(degree);
+}
+
+void CalibrationWorkflow::setAggregator(RobustSampleBuffer* buffer, RobustMode mode) {
+    _robust = buffer;
+    _robustMode = mode;
+}
+
+bool CalibrationWorkflow::start(const WorkflowStep* steps, uint8_t count) {
+    if (!steps || !_sampler || !_channel || count < _fitter.degree() + 1) {
+        return false;
+    }
+    _steps = steps;
+    _stepCount = count;
+    _error = CAL_OK;
+    _fitter.reset();
+    memset(&_fit, 0, sizeof(_fit));
+    enterStep(0, millis());
+    return true;
+}
+
+void CalibrationWorkflow::cancel() {
+    if (isActive() && _output) {
+        _output->println("Calibration cancelled");
+    }
+    _state = WORKFLOW_IDLE;
+}
+
+void CalibrationWorkflow::confirm() {
+    _confirmed = true;
+}
+
+void CalibrationWorkflow::enterStep(uint8_t step, uint32_t nowMs) {
+    _step = step;
+    _confirmed = false;
+    _samples.reset();
+    if (_robust) {
+        _robust->reset();
+    }
+    _samples.setTarget(_steps[step].samples ? _steps[step].samples : 1);
+    _stateStartMs = nowMs;
+    _state = WORKFLOW_PROMPT;
+    if (_steps[step].prompt && _output) {
+        _output->printf("Step %u/%u: %s\n", step + 1, _stepCount, _steps[step].prompt);
+    }
+}
+
+void CalibrationWorkflow::fail(CalibrationError error) {
+    _error = error;
+    _state = WORKFLOW_FAILED;
+    if (_output) {
+        _output->printf("Calibration failed: %s\n", _calibration.getErrorString(error));
+    }
+}
+
+WorkflowState CalibrationWorkflow::tick() {
+    return tick(millis());
+}
+
+WorkflowState CalibrationWorkflow::tick(uint32_t nowMs) {
+    switch (_state) {
+        case WORKFLOW_PROMPT:
+            if (_confirmed || !_steps[_step].prompt) {
+                _stateStartMs = nowMs;
+                _state = WORKFLOW_SETTLE;
+            }
+            break;
+
+        case WORKFLOW_SETTLE:
+            if (nowMs - _stateStartMs >= _steps[_step].settleMs) {
+                // Take the first sample on the next tick
+                _lastSampleMs = nowMs - _sampleIntervalMs;
+                _state = WORKFLOW_SAMPLE;
+            }
+            break;
+
+        case WORKFLOW_SAMPLE: {
+            if (nowMs - _lastSampleMs < _sampleIntervalMs) {
+                break;
+            }
+            _lastSampleMs = nowMs;
+            float raw = _sampler(_context);
+            _samples.add(raw);
+            if (_robust) {
+                _robust->add(raw);
+            }
+            if (_samples.isReady()) {
+                // The averaged point carries the weight of all its samples
+                _lastRaw = _robust ? _robust->value(_robustMode) : _samples.mean();
+                _fitter.addPoint(_lastRaw, _steps[_step].reference, _samples.count());
+                if (_output) {
+                    _output->printf("Step %u/%u: raw %.3f -> %.3f (stddev %.3f)\n", _step + 1,
+                                    _stepCount, _lastRaw, _steps[_step].reference, _samples.stddev());
+                }
+                if (_step + 1 < _stepCount) {
+                    enterStep(_step + 1, nowMs);
+                } else {
+                    _state = WORKFLOW_COMPUTE;
+                }
+            }
+            break;
+        }
+
+        case WORKFLOW_COMPUTE:
+            if (!_fitter.fit(_transform, &_fit) ||
+                (_maxResidual > 0.0f && _fit.rmse > _maxResidual)) {
+                fail(CAL_INVALID_PARAM);
+                break;
+            }
+            _state = WORKFLOW_COMMIT;
+            break;
+
+        case WORKFLOW_COMMIT: {
+            CalibrationError error = _calibration.storeTransform(_channel, _transform);
+            if (error != CAL_OK) {
+                fail(error);
+                break;
+            }
+            _state = WORKFLOW_DONE;
+            if (_output) {
+                _output->printf("Calibration of '%s' stored (rmse %.4f)\n", _channel, _fit.rmse);
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+    return _state;
+}
@@ -0,0 +1,119 @@
+#ifndef CALIBRATION_WORKFLOW_H
+#define CALIBRATION_WORKFLOW_H
+
+#include "CalibrationLib.h"
+
+// Workflow progress. Each tick() does at most one state's worth of work.
+enum WorkflowState : uint8_t {
+    WORKFLOW_IDLE = 0,
+    WORKFLOW_PROMPT,    // waiting for confirm() before a reference point
+    WORKFLOW_SETTLE,    // letting the input settle after confirmation
+    WORKFLOW_SAMPLE,    // collecting samples for the current point
+    WORKFLOW_COMPUTE,   // fitting the model through all points
+    WORKFLOW_COMMIT,    // storing the model
+    WORKFLOW_DONE,
+    WORKFLOW_FAILED
+};
+
+// One reference point of a calibration procedure
+struct WorkflowStep {
+    const char* prompt;     // printed on entry; nullptr starts without confirm()
+    float reference;        // true value while this step is sampled
+    uint32_t settleMs;      // delay between confirmation and the first sample
+    uint32_t samples;       // samples averaged into the point
+};
+
+// Returns one raw reading of the input being calibrated
+typedef float (*WorkflowSampler)(void* context);
+
+// Non-blocking, step-by-step calibration driven from loop(). The workflow
+// walks prompt -> settle -> sample for every step, then fits a model through
+// the averaged points and stores it with storeTransform():
+//
+//   const WorkflowStep steps[] = {
+//       {"Place sensor in ice water, then press c", 0.0f, 2000, 20},
+//       {"Place sensor in boiling water, then press c", 100.0f, 2000, 20},
+//   };
+//   CalibrationWorkflow workflow(calib, "temp", readTemp, nullptr);
+//   workflow.start(steps, 2);
+//
+//   void loop() {
+//       if (Serial.read() == 'c') workflow.confirm();
+//       workflow.tick();
+//       // networking and other sensors keep running
+//   }
+class CalibrationWorkflow {
+public:
+    CalibrationWorkflow(CalibrationLib& calibration, const char* channel,
+                        WorkflowSampler sampler, void* context = nullptr);
+
+    // Where prompts and progress go (default Serial); nullptr for silence
+    void setOutput(Print* output) { _output = output; }
+    void setSampleInterval(uint32_t intervalMs) { _sampleIntervalMs = intervalMs; }
+    // Polynomial degree of the fitted model; needs at least degree + 1 steps
+    bool setDegree(uint8_t degree);
+    // Fail in COMPUTE if the fit's RMS residual exceeds this (0 disables)
+    void setMaxResidual(float rmse) { _maxResidual = rmse; }
+    // Reduce each step's samples with an outlier-resistant aggregate
+    // instead of the mean; buffer must hold the largest step's samples and
+    // outlive the workflow (nullptr returns to the mean)
+    void setAggregator(RobustSampleBuffer* buffer, RobustMode mode = ROBUST_MEDIAN);
+
+    // steps must stay valid until the workflow finishes
+    bool start(const WorkflowStep* steps, uint8_t count);
+    void cancel();
+    // Acknowledges the current prompt
+    void confirm();
+
+    // Advances the state machine; call every loop() pass
+    WorkflowState tick();
+    WorkflowState tick(uint32_t nowMs);
+
+    WorkflowState state() const { return _state; }
+    bool isActive() const { return _state != WORKFLOW_IDLE && _state != WORKFLOW_DONE && _state != WORKFLOW_FAILED; }
+    uint8_t currentStep() const { return _step; }
+    uint8_t stepCount() const { return _stepCount; }
+    // Samples taken so far for the current step
+    uint32_t samplesTaken() const { return _samples.count(); }
+    // Latest completed step's averaged raw reading
+    float lastPointRaw() const { return _lastRaw; }
+
+    const CalibrationTransform& transform() const { return _transform; }
+    const FitResult& fitResult() const { return _fit; }
+    // Why the workflow failed: CAL_INVALID_PARAM if the points could not be
+    // fitted or the residual was too large, otherwise the storage error
+    CalibrationError error() const { return _error; }
+
+    static const char* getStateName(WorkflowState state);
+
+private:
+    void enterStep(uint8_t step, uint32_t nowMs);
+    void fail(CalibrationError error);
+
+    CalibrationLib& _calibration;
+    const char* _channel;
+    WorkflowSampler _sampler;
+    void* _context;
+    Print* _output;
+
+    const WorkflowStep* _steps;
+    uint8_t _stepCount;
+    uint8_t _step;
+    WorkflowState _state;
+    bool _confirmed;
+    uint32_t _stateStartMs;
+    uint32_t _lastSampleMs;
+    uint32_t _sampleIntervalMs;
+    float _maxResidual;
+    float _lastRaw;
+    CalibrationError _error;
+
+    SampleAccumulator _samples;
+    RobustSampleBuffer* _robust;
+    RobustMode _robustMode;
+    CalibrationFitter _fitter;
+    CalibrationTransform _transform;
+    FitResult _fit;
+};
+
+#endif